@@ -0,0 +1,186 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "atomics.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+void gpubench::Atomics::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::Atomics::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::Atomics::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::Atomics::run(unsigned int repetitions) {
+
+    cl_int err;
+
+    size_t const max_local_size = 256;
+    size_t const groups_per_compute_unit = 8;
+    cl_uint const iterations = 256;
+
+    int const num_memories = 2;
+    char const* memories[] = {"global", "local"};
+    char const* kernel_names[] = {"global_atomic_add", "local_atomic_add"};
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "atomics.cl",
+                NULL,
+                program
+                ));
+
+    profiler_->add_table(
+            "atomics",
+            {"memory", "counters", "work-items per counter", "atomics",
+            "median (us)", "Gatomics/s"});
+
+    for (int m = 0; m < num_memories; ++m) {
+        cl::Kernel kernel;
+        cle_sanitize_ref_return(
+                kernel = cl::Kernel(program, kernel_names[m], &err),
+                err
+                );
+
+        size_t local_size = std::min(
+                max_local_size,
+                kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+        size_t global_size = local_size
+            * groups_per_compute_unit
+            * device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+
+        // From all work-items (of a work-group for local counters) on one
+        // counter to one counter each
+        std::vector<size_t> counter_counts;
+        if (m == 0) {
+            counter_counts = {1, 32, 1024, 32768};
+            counter_counts.push_back(global_size);
+        }
+        else {
+            counter_counts = {1, 4, 32};
+            counter_counts.push_back(local_size);
+        }
+
+        // Local counters must not exceed the local size, small work-groups
+        // can also repeat a count
+        size_t max_counters = (m == 0) ? global_size : local_size;
+        counter_counts.erase(
+                std::remove_if(
+                    counter_counts.begin(),
+                    counter_counts.end(),
+                    [max_counters](size_t count) { return count > max_counters; }),
+                counter_counts.end());
+        std::sort(counter_counts.begin(), counter_counts.end());
+        counter_counts.erase(
+                std::unique(counter_counts.begin(), counter_counts.end()),
+                counter_counts.end());
+
+        for (size_t num_counters : counter_counts) {
+
+            cle::TypedBuffer<cl_uint> d_counters(
+                    context_,
+                    CL_MEM_READ_WRITE,
+                    num_counters,
+                    NULL
+                    );
+
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueFillBuffer(
+                        d_counters,
+                        (cl_uint) 0,
+                        0,
+                        d_counters.bytes(),
+                        NULL,
+                        NULL));
+
+            kernel.setArg(0, d_counters);
+            if (m == 0) {
+                kernel.setArg(1, (cl_uint) num_counters);
+                kernel.setArg(2, iterations);
+            }
+            else {
+                kernel.setArg(1, cl::Local(num_counters * sizeof(cl_uint)));
+                kernel.setArg(2, (cl_uint) num_counters);
+                kernel.setArg(3, iterations);
+            }
+
+            uint64_t atomics = (uint64_t) global_size * iterations;
+            GpuBench::Statistics time;
+            cle_sanitize_val_return(
+                    GpuBench::time_kernel(
+                        commandqueue_,
+                        kernel,
+                        cl::NDRange(global_size),
+                        cl::NDRange(local_size),
+                        repetitions,
+                        *profiler_,
+                        std::string(memories[m]) + " atomic add "
+                            + std::to_string(num_counters),
+                        0,
+                        time));
+
+            // The warm up and every repetition each add global size * iterations
+            std::vector<cl_uint> h_counters(num_counters);
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueReadBuffer(
+                        d_counters,
+                        CL_TRUE,
+                        0,
+                        d_counters.bytes(),
+                        h_counters.data(),
+                        NULL,
+                        NULL));
+
+            cl_uint sum = 0;
+            for (cl_uint counter : h_counters) {
+                sum += counter;
+            }
+            if (sum != (cl_uint) (atomics * (repetitions + 1))) {
+                std::cerr << "Wrong " << memories[m] << " atomic sum with "
+                    << num_counters << " counters" << std::endl;
+                return -1;
+            }
+
+            profiler_->add_row({
+                    memories[m],
+                    num_counters,
+                    (double) (m == 0 ? global_size : local_size) / num_counters,
+                    atomics,
+                    time.median / 1000.0,
+                    time.median ? (double) atomics / time.median : 0
+                    });
+        }
+    }
+
+    return 1;
+}
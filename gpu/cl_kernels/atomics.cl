@@ -0,0 +1,55 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Atomic add throughput under contention
+ *
+ * Work-item i adds to counter i % num_counters, so num_counters sets how
+ * many work-items contend for each counter. Every counter ends up with
+ * its share of global size * iterations (modulo 2^32), which the host
+ * checks.
+ */
+__kernel void global_atomic_add(
+        __global uint *counters,
+        const uint num_counters,
+        const uint iterations) {
+    __global uint *counter = &counters[get_global_id(0) % num_counters];
+
+    for (uint i = 0; i < iterations; ++i) {
+        atomic_add(counter, 1u);
+    }
+}
+
+/*
+ * Same with counters in local memory, num_counters must not exceed the
+ * local size. Each work-group adds its counters to the global ones.
+ */
+__kernel void local_atomic_add(
+        __global uint *counters,
+        __local uint *local_counters,
+        const uint num_counters,
+        const uint iterations) {
+    uint lid = get_local_id(0);
+    uint size = get_local_size(0);
+
+    for (uint i = lid; i < num_counters; i += size) {
+        local_counters[i] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    __local uint *counter = &local_counters[lid % num_counters];
+    for (uint i = 0; i < iterations; ++i) {
+        atomic_add(counter, 1u);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (uint i = lid; i < num_counters; i += size) {
+        atomic_add(&counters[i], local_counters[i]);
+    }
+}
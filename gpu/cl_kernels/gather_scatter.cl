@@ -0,0 +1,34 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Gather and scatter through an index buffer (grid-stride loop)
+ *
+ * The index pattern, from sequential to a random permutation, decides
+ * how scattered the accesses to in (gather) or out (scatter) are.
+ */
+__kernel void gather(
+        __global const uint *in,
+        __global const uint *indices,
+        __global uint *out,
+        const uint n) {
+    for (uint i = get_global_id(0); i < n; i += get_global_size(0)) {
+        out[i] = in[indices[i]];
+    }
+}
+
+__kernel void scatter(
+        __global const uint *in,
+        __global const uint *indices,
+        __global uint *out,
+        const uint n) {
+    for (uint i = get_global_id(0); i < n; i += get_global_size(0)) {
+        out[indices[i]] = in[i];
+    }
+}
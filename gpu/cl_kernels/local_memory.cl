@@ -0,0 +1,45 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Local memory bandwidth with strided access
+ *
+ * Work-item i of a work-group first reads slot i, then slot i + 1 and so
+ * on, wrapping at the local size. Slot j lives at scratch[j * stride], so
+ * the stride decides how many work-items of a wavefront share a bank.
+ * The scratch buffer holds local size * stride floats.
+ *
+ * The result is only stored if it equals flag, which the host never
+ * lets happen. This keeps the compiler from eliminating the loads.
+ */
+__kernel void local_read(
+        __global float *out,
+        __local float *scratch,
+        const uint stride,
+        const uint iterations,
+        const float flag) {
+    uint lid = get_local_id(0);
+    uint size = get_local_size(0);
+
+    for (uint i = lid; i < size * stride; i += size) {
+        scratch[i] = (float) i;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    float sum = 0;
+    uint slot = lid;
+    for (uint i = 0; i < iterations; ++i) {
+        sum += scratch[slot * stride];
+        slot = (slot + 1 == size) ? 0 : slot + 1;
+    }
+
+    if (sum == flag) {
+        out[get_global_id(0)] = sum;
+    }
+}
@@ -0,0 +1,149 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Global memory bandwidth kernels
+ *
+ * Build with -DVEC_WIDTH=1, 2, 4, 8 or 16 to select the element type.
+ *
+ * Coalesced kernels let neighbouring work-items access neighbouring
+ * elements (grid-stride loop). Strided kernels give each work-item one
+ * contiguous chunk, so neighbouring work-items are a chunk apart.
+ */
+
+#ifndef VEC_WIDTH
+#define VEC_WIDTH 1
+#endif
+
+#define REDUCE2(x) ((x).s0 + (x).s1)
+#define REDUCE4(x) REDUCE2((x).lo + (x).hi)
+#define REDUCE8(x) REDUCE4((x).lo + (x).hi)
+#define REDUCE16(x) REDUCE8((x).lo + (x).hi)
+
+#if VEC_WIDTH == 1
+typedef float vec_t;
+#define REDUCE(x) (x)
+#elif VEC_WIDTH == 2
+typedef float2 vec_t;
+#define REDUCE(x) REDUCE2(x)
+#elif VEC_WIDTH == 4
+typedef float4 vec_t;
+#define REDUCE(x) REDUCE4(x)
+#elif VEC_WIDTH == 8
+typedef float8 vec_t;
+#define REDUCE(x) REDUCE8(x)
+#elif VEC_WIDTH == 16
+typedef float16 vec_t;
+#define REDUCE(x) REDUCE16(x)
+#else
+#error "VEC_WIDTH must be 1, 2, 4, 8 or 16"
+#endif
+
+#define COALESCED_LOOP(i, n) \
+    for (uint i = get_global_id(0); i < n; i += get_global_size(0))
+
+#define STRIDED_LOOP(i, n) \
+    uint chunk_ = (n + get_global_size(0) - 1) / get_global_size(0); \
+    uint begin_ = get_global_id(0) * chunk_; \
+    uint end_ = min(begin_ + chunk_, n); \
+    for (uint i = begin_; i < end_; ++i)
+
+/*
+ * The result is only stored if it equals flag, which the host never
+ * lets happen. This keeps the compiler from eliminating the loads.
+ */
+__kernel void read_coalesced(
+        __global const vec_t *in,
+        __global float *out,
+        const uint n,
+        const float flag) {
+    vec_t sum = 0;
+
+    COALESCED_LOOP(i, n) {
+        sum += in[i];
+    }
+
+    if (REDUCE(sum) == flag) {
+        out[get_global_id(0)] = REDUCE(sum);
+    }
+}
+
+__kernel void read_strided(
+        __global const vec_t *in,
+        __global float *out,
+        const uint n,
+        const float flag) {
+    vec_t sum = 0;
+
+    STRIDED_LOOP(i, n) {
+        sum += in[i];
+    }
+
+    if (REDUCE(sum) == flag) {
+        out[get_global_id(0)] = REDUCE(sum);
+    }
+}
+
+__kernel void write_coalesced(
+        __global vec_t *out,
+        const uint n,
+        const float value) {
+    COALESCED_LOOP(i, n) {
+        out[i] = (vec_t) value;
+    }
+}
+
+__kernel void write_strided(
+        __global vec_t *out,
+        const uint n,
+        const float value) {
+    STRIDED_LOOP(i, n) {
+        out[i] = (vec_t) value;
+    }
+}
+
+__kernel void copy_coalesced(
+        __global const vec_t *in,
+        __global vec_t *out,
+        const uint n) {
+    COALESCED_LOOP(i, n) {
+        out[i] = in[i];
+    }
+}
+
+__kernel void copy_strided(
+        __global const vec_t *in,
+        __global vec_t *out,
+        const uint n) {
+    STRIDED_LOOP(i, n) {
+        out[i] = in[i];
+    }
+}
+
+__kernel void triad_coalesced(
+        __global vec_t *a,
+        __global const vec_t *b,
+        __global const vec_t *c,
+        const float scalar,
+        const uint n) {
+    COALESCED_LOOP(i, n) {
+        a[i] = b[i] + scalar * c[i];
+    }
+}
+
+__kernel void triad_strided(
+        __global vec_t *a,
+        __global const vec_t *b,
+        __global const vec_t *c,
+        const float scalar,
+        const uint n) {
+    STRIDED_LOOP(i, n) {
+        a[i] = b[i] + scalar * c[i];
+    }
+}
@@ -0,0 +1,25 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Compute-bound kernel to overlap with transfers
+ * Run time scales linearly with iterations
+ */
+__kernel void busy(
+        __global float *data,
+        const uint iterations) {
+    size_t gid = get_global_id(0);
+    float x = data[gid];
+
+    for (uint i = 0; i < iterations; ++i) {
+        x = mad(x, 0.999f, 0.001f);
+    }
+
+    data[gid] = x;
+}
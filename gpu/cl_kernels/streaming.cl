@@ -0,0 +1,20 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Trivial per-chunk processing, memory bound on any device
+ */
+__kernel void scale(
+        __global float *data,
+        const uint n,
+        const float factor) {
+    for (uint i = get_global_id(0); i < n; i += get_global_size(0)) {
+        data[i] *= factor;
+    }
+}
@@ -0,0 +1,194 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Work-group variance reductions
+ *
+ * Every kernel writes three doubles per work-group to partials:
+ *   naive:   count, sum, sum of squares
+ *   kahan:   count, compensated sum, compensated sum of squares
+ *   welford: count, mean, sum of squared differences from the mean (M2)
+ * The host merges the partials of all work-groups.
+ *
+ * The local size must be a power of two. scratch must hold
+ * 5 * local size doubles.
+ */
+
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+
+/*
+ * Error of the floating point addition t = a + b (Knuth's TwoSum)
+ */
+inline double two_sum_error(double a, double b, double t) {
+    double b_virtual = t - a;
+    return (a - (t - b_virtual)) + (b - b_virtual);
+}
+
+__kernel void variance_naive(
+        __global const double *x,
+        const ulong n,
+        __global double *partials,
+        __local double *scratch) {
+    size_t lid = get_local_id(0);
+    size_t lsize = get_local_size(0);
+    __local double *l_count = scratch;
+    __local double *l_sum = scratch + lsize;
+    __local double *l_squares = scratch + 2 * lsize;
+    double count = 0;
+    double sum = 0;
+    double squares = 0;
+
+    for (ulong i = get_global_id(0); i < n; i += get_global_size(0)) {
+        count += 1;
+        sum += x[i];
+        squares += x[i] * x[i];
+    }
+
+    l_count[lid] = count;
+    l_sum[lid] = sum;
+    l_squares[lid] = squares;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (size_t s = lsize / 2; s > 0; s >>= 1) {
+        if (lid < s) {
+            l_count[lid] += l_count[lid + s];
+            l_sum[lid] += l_sum[lid + s];
+            l_squares[lid] += l_squares[lid + s];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        size_t group = get_group_id(0);
+        partials[3 * group] = l_count[0];
+        partials[3 * group + 1] = l_sum[0];
+        partials[3 * group + 2] = l_squares[0];
+    }
+}
+
+/*
+ * Sums and their rounding errors are carried separately (Kahan-Babuska)
+ * and only added at the end of the reduction
+ */
+__kernel void variance_kahan(
+        __global const double *x,
+        const ulong n,
+        __global double *partials,
+        __local double *scratch) {
+    size_t lid = get_local_id(0);
+    size_t lsize = get_local_size(0);
+    __local double *l_count = scratch;
+    __local double *l_sum = scratch + lsize;
+    __local double *l_c_sum = scratch + 2 * lsize;
+    __local double *l_squares = scratch + 3 * lsize;
+    __local double *l_c_squares = scratch + 4 * lsize;
+    double count = 0;
+    double sum = 0;
+    double c_sum = 0;
+    double squares = 0;
+    double c_squares = 0;
+    double t = 0;
+
+    for (ulong i = get_global_id(0); i < n; i += get_global_size(0)) {
+        double val = x[i];
+        double squared = val * val;
+
+        count += 1;
+
+        t = sum + val;
+        c_sum += two_sum_error(sum, val, t);
+        sum = t;
+
+        t = squares + squared;
+        c_squares += two_sum_error(squares, squared, t);
+        squares = t;
+    }
+
+    l_count[lid] = count;
+    l_sum[lid] = sum;
+    l_c_sum[lid] = c_sum;
+    l_squares[lid] = squares;
+    l_c_squares[lid] = c_squares;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (size_t s = lsize / 2; s > 0; s >>= 1) {
+        if (lid < s) {
+            l_count[lid] += l_count[lid + s];
+
+            t = l_sum[lid] + l_sum[lid + s];
+            l_c_sum[lid] += l_c_sum[lid + s]
+                + two_sum_error(l_sum[lid], l_sum[lid + s], t);
+            l_sum[lid] = t;
+
+            t = l_squares[lid] + l_squares[lid + s];
+            l_c_squares[lid] += l_c_squares[lid + s]
+                + two_sum_error(l_squares[lid], l_squares[lid + s], t);
+            l_squares[lid] = t;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        size_t group = get_group_id(0);
+        partials[3 * group] = l_count[0];
+        partials[3 * group + 1] = l_sum[0] + l_c_sum[0];
+        partials[3 * group + 2] = l_squares[0] + l_c_squares[0];
+    }
+}
+
+/*
+ * Welford's update per work-item, Chan et al. pairwise merge in the tree
+ */
+__kernel void variance_welford(
+        __global const double *x,
+        const ulong n,
+        __global double *partials,
+        __local double *scratch) {
+    size_t lid = get_local_id(0);
+    size_t lsize = get_local_size(0);
+    __local double *l_count = scratch;
+    __local double *l_mean = scratch + lsize;
+    __local double *l_m2 = scratch + 2 * lsize;
+    double count = 0;
+    double mean = 0;
+    double m2 = 0;
+
+    for (ulong i = get_global_id(0); i < n; i += get_global_size(0)) {
+        double delta = x[i] - mean;
+        count += 1;
+        mean += delta / count;
+        m2 += delta * (x[i] - mean);
+    }
+
+    l_count[lid] = count;
+    l_mean[lid] = mean;
+    l_m2[lid] = m2;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (size_t s = lsize / 2; s > 0; s >>= 1) {
+        if (lid < s && l_count[lid + s] > 0) {
+            double count_a = l_count[lid];
+            double count_b = l_count[lid + s];
+            double merged = count_a + count_b;
+            double delta = l_mean[lid + s] - l_mean[lid];
+
+            l_mean[lid] += delta * count_b / merged;
+            l_m2[lid] += l_m2[lid + s] + delta * delta * count_a * count_b / merged;
+            l_count[lid] = merged;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        size_t group = get_group_id(0);
+        partials[3 * group] = l_count[0];
+        partials[3 * group + 1] = l_mean[0];
+        partials[3 * group + 2] = l_m2[0];
+    }
+}
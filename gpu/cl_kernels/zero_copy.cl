@@ -0,0 +1,29 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+/*
+ * Read all n values passes times
+ * Each work-item writes its partial sum, so the result buffer has one
+ * value per work-item.
+ */
+__kernel void touch(
+        __global const float *in,
+        __global float *out,
+        const uint n,
+        const uint passes) {
+    float sum = 0;
+
+    for (uint p = 0; p < passes; ++p) {
+        for (uint i = get_global_id(0); i < n; i += get_global_size(0)) {
+            sum += in[i];
+        }
+    }
+
+    out[get_global_id(0)] = sum;
+}
@@ -0,0 +1,33 @@
+# This Source Code Form is subject to the terms of the Mozilla Public License,
+# v. 2.0. If a copy of the MPL was not distributed with this file, You can
+# obtain one at http://mozilla.org/MPL/2.0/.
+# 
+# 
+# Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+
+# Run gpubench once and check that it succeeds and prints the expected table
+#
+# cmake -DGPUBENCH=<executable> -DARGS="<options>" -DTABLE="<table name>"
+#       -P SmokeTest.cmake
+
+SEPARATE_ARGUMENTS(GPUBENCH_ARGS UNIX_COMMAND "${ARGS}")
+
+EXECUTE_PROCESS(
+    COMMAND ${GPUBENCH} ${GPUBENCH_ARGS}
+    RESULT_VARIABLE RESULT
+    OUTPUT_VARIABLE OUTPUT
+    ERROR_VARIABLE ERROR
+    )
+
+IF(NOT RESULT EQUAL 0)
+    MESSAGE(FATAL_ERROR
+        "gpubench ${ARGS} exited with ${RESULT}\n${OUTPUT}\n${ERROR}")
+ENDIF(NOT RESULT EQUAL 0)
+
+STRING(FIND "${OUTPUT}" "\n# ${TABLE}\n" TABLE_POSITION)
+IF(TABLE_POSITION EQUAL -1)
+    MESSAGE(FATAL_ERROR
+        "gpubench ${ARGS} did not print table \"${TABLE}\"\n${OUTPUT}\n${ERROR}")
+ENDIF(TABLE_POSITION EQUAL -1)
+
+MESSAGE("${OUTPUT}")
@@ -1,31 +1,242 @@
 #include "common.hpp"
+#include "profiler.hpp"
+#include "program_cache.hpp"
+#include "SystemConfig.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <clext.hpp>
 
+#include <datagen.h>
+
 #ifdef MAC
 #include <OpenCL/cl.hpp>
 #else
 #include <CL/cl.hpp>
 #endif
 
-uint64_t GpuBench::event_nanoseconds(cl::Event const& event, uint64_t& time) {
-    cl_ulong start, end;
+/*
+ * Min, median and 99th percentile (nearest rank) of samples
+ */
+GpuBench::Statistics GpuBench::statistics(std::vector<uint64_t> samples) {
+    Statistics stats = {0, 0, 0};
+
+    if (samples.empty()) {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    size_t p99_rank = (samples.size() * 99 + 99) / 100;
+
+    stats.min = samples.front();
+    stats.median = samples[(samples.size() - 1) / 2];
+    stats.p99 = samples[p99_rank - 1];
+
+    return stats;
+}
+
+cl_int GpuBench::time_kernel(
+        cl::CommandQueue const& queue,
+        cl::Kernel const& kernel,
+        cl::NDRange const& global,
+        cl::NDRange const& local,
+        unsigned int repetitions,
+        gpubench::Profiler& profiler,
+        std::string const& name,
+        size_t bytes,
+        Statistics& time) {
 
     cle_sanitize_val_return(
-            event.wait()
-            );
+            queue.enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                global,
+                local,
+                NULL,
+                NULL));
+
+    for (unsigned int r = 0; r < repetitions; ++r) {
+        cl::Event event;
+        cle_sanitize_val_return(
+                queue.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NullRange,
+                    global,
+                    local,
+                    NULL,
+                    &event));
+        profiler.add_event(name, event, bytes);
+    }
 
     cle_sanitize_val_return(
-            event.getProfilingInfo(CL_PROFILING_COMMAND_START, &start)
+            profiler.collect(queue));
+
+    std::vector<uint64_t> times;
+    for (gpubench::Profiler::Record const& record : profiler.last_records(repetitions)) {
+        times.push_back(record.execution_time());
+    }
+    time = statistics(times);
+
+    return CL_SUCCESS;
+}
+
+/*
+ * Pairwise merge of two partial moments (Chan et al.)
+ */
+GpuBench::Moments GpuBench::merge_moments(Moments const& a, Moments const& b) {
+    if (a.count == 0) {
+        return b;
+    }
+
+    if (b.count == 0) {
+        return a;
+    }
+
+    Moments merged;
+    double delta = b.mean - a.mean;
+
+    merged.count = a.count + b.count;
+    merged.mean = a.mean + delta * b.count / merged.count;
+    merged.m2 = a.m2 + b.m2 + delta * delta * a.count * b.count / merged.count;
+
+    return merged;
+}
+
+void GpuBench::generate_dataset(size_t dataset, std::vector<double>& values) {
+    // datagen draws from the global rand() state
+    static std::mutex rand_mutex;
+    std::lock_guard<std::mutex> lock(rand_mutex);
+
+    srand(42 + dataset);
+    datasets[dataset].generate(values.data(), values.size());
+}
+
+long double GpuBench::reference_variance(std::vector<double> const& x) {
+    long double sum = 0;
+    long double squares = 0;
+
+    for (double val : x) {
+        sum += val;
+    }
+
+    long double mean = sum / x.size();
+
+    for (double val : x) {
+        long double diff = val - mean;
+        squares += diff * diff;
+    }
+
+    return squares / x.size();
+}
+
+double GpuBench::relative_error(double value, long double reference) {
+    long double error = std::fabs(value - reference);
+
+    if (reference != 0) {
+        error /= std::fabs(reference);
+    }
+
+    return (double) error;
+}
+
+namespace {
+    gpubench::ProgramCache *program_cache = NULL;
+}
+
+cl_int GpuBench::read_kernel_source(char const* file_name, std::string& source) {
+    // The smoke tests run from the build tree before the kernels are installed
+    char const* kernels_path = std::getenv("GPUBENCH_CL_KERNELS_PATH");
+    if (!kernels_path || !*kernels_path) {
+        kernels_path = CL_KERNELS_PATH;
+    }
+
+    std::string path = std::string(kernels_path) + "/" + file_name;
+    std::ifstream file(path.c_str());
+    if (!file.good()) {
+        std::cerr << "Cannot open kernel file " << path << std::endl;
+        return CL_INVALID_VALUE;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    source = ss.str();
+
+    return CL_SUCCESS;
+}
+
+cl_int GpuBench::build_program_source(
+        cl::Context const& context,
+        cl::Device const& device,
+        char const* file_name,
+        std::string const& source,
+        char const* build_options,
+        cl::Program& program) {
+
+    cl_int err;
+
+    cl::Program::Sources sources(
+            1,
+            std::make_pair(source.c_str(), source.length())
             );
 
-    cle_sanitize_val_return(
-            event.getProfilingInfo(CL_PROFILING_COMMAND_END, &end)
+    std::vector<cl::Device> devices(1, device);
+
+    cle_sanitize_ref_return(
+            program = cl::Program(context, sources, &err),
+            err
             );
 
-    time = end - start;
+    err = program.build(devices, build_options);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Build of " << file_name << " failed:\n"
+            << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device)
+            << std::endl;
+        return err;
+    }
 
     return CL_SUCCESS;
 }
+
+void GpuBench::set_program_cache(gpubench::ProgramCache *cache) {
+    program_cache = cache;
+}
+
+cl_int GpuBench::build_program(
+        cl::Context const& context,
+        cl::Device const& device,
+        char const* file_name,
+        char const* build_options,
+        cl::Program& program) {
+
+    std::string source;
+    cle_sanitize_val_return(
+            read_kernel_source(file_name, source));
+
+    if (program_cache) {
+        return program_cache->build(
+                context,
+                device,
+                file_name,
+                source,
+                build_options,
+                program);
+    }
+
+    return build_program_source(
+            context,
+            device,
+            file_name,
+            source,
+            build_options,
+            program);
+}
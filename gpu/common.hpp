@@ -2,6 +2,8 @@
 #define COMMON_HPP
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #ifdef MAC
 #include <OpenCL/cl.hpp>
@@ -9,8 +11,78 @@
 #include <CL/cl.hpp>
 #endif
 
+namespace gpubench {
+    class ProgramCache;
+    class Profiler;
+}
+
 namespace GpuBench {
-    uint64_t event_nanoseconds(cl::Event const& event, uint64_t& time);
+    // Count, mean and sum of squared differences from the mean
+    struct Moments {
+        double count;
+        double mean;
+        double m2;
+    };
+
+    // Profiling timestamps of one command in device nanoseconds
+    struct EventPhases {
+        cl_ulong queued;
+        cl_ulong submit;
+        cl_ulong start;
+        cl_ulong end;
+    };
+
+    struct Statistics {
+        uint64_t min;
+        uint64_t median;
+        uint64_t p99;
+    };
+
+    Statistics statistics(std::vector<uint64_t> samples);
+
+    // Warm up, then run kernel repetitions times and profile each run
+    cl_int time_kernel(
+            cl::CommandQueue const& queue,
+            cl::Kernel const& kernel,
+            cl::NDRange const& global,
+            cl::NDRange const& local,
+            unsigned int repetitions,
+            gpubench::Profiler& profiler,
+            std::string const& name,
+            size_t bytes,
+            Statistics& time);
+
+    Moments merge_moments(Moments const& a, Moments const& b);
+
+    // Two-pass variance in extended precision as accuracy reference
+    long double reference_variance(std::vector<double> const& x);
+
+    double relative_error(double value, long double reference);
+
+    // Fill values with the given datagen dataset. The data only depends
+    // on the dataset, so concurrent device runs see the same input.
+    void generate_dataset(size_t dataset, std::vector<double>& values);
+
+    cl_int read_kernel_source(char const* file_name, std::string& source);
+
+    // The file name only labels build errors
+    cl_int build_program_source(
+            cl::Context const& context,
+            cl::Device const& device,
+            char const* file_name,
+            std::string const& source,
+            char const* build_options,
+            cl::Program& program);
+
+    // Programs are built through the cache if one is set
+    void set_program_cache(gpubench::ProgramCache *cache);
+
+    cl_int build_program(
+            cl::Context const& context,
+            cl::Device const& device,
+            char const* file_name,
+            char const* build_options,
+            cl::Program& program);
 }
 
 #endif /* COMMON_HPP */
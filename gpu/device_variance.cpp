@@ -0,0 +1,210 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "device_variance.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+gpubench::DeviceVariance::Method const
+gpubench::DeviceVariance::methods[gpubench::DeviceVariance::num_methods] = {
+    Method::Naive,
+    Method::Kahan,
+    Method::Welford
+};
+
+char const* gpubench::DeviceVariance::method_name(Method method) {
+    switch (method) {
+        case Method::Naive:
+            return "OpenCL naive";
+        case Method::Kahan:
+            return "OpenCL Kahan";
+        case Method::Welford:
+            return "OpenCL Welford";
+    }
+
+    return "";
+}
+
+cl_int gpubench::DeviceVariance::init(cl::Context context, cl::CommandQueue queue) {
+
+    cl_int err;
+
+    size_t const max_local_size = 256;
+    size_t const groups_per_compute_unit = 4;
+
+    char const* kernel_names[num_methods] = {
+        "variance_naive",
+        "variance_kahan",
+        "variance_welford"
+    };
+
+    context_ = context;
+    commandqueue_ = queue;
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    std::string extensions = device.getInfo<CL_DEVICE_EXTENSIONS>();
+    if (extensions.find("cl_khr_fp64") == std::string::npos) {
+        std::cerr << "Device does not support double precision" << std::endl;
+        return CL_INVALID_OPERATION;
+    }
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "variance.cl",
+                NULL,
+                program
+                ));
+
+    kernels_.clear();
+    local_size_ = max_local_size;
+    for (int m = 0; m < num_methods; ++m) {
+        cl::Kernel kernel;
+        cle_sanitize_ref_return(
+                kernel = cl::Kernel(program, kernel_names[m], &err),
+                err
+                );
+
+        local_size_ = std::min(
+                local_size_,
+                kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+
+        kernels_.push_back(kernel);
+    }
+
+    // The tree reduction needs a power of two
+    size_t power_of_two = 1;
+    while (power_of_two * 2 <= local_size_) {
+        power_of_two *= 2;
+    }
+    local_size_ = power_of_two;
+
+    num_groups_ = groups_per_compute_unit
+        * device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+
+    h_partials_.resize(3 * num_groups_);
+
+    cle_sanitize_ref_return(
+            d_partials_ = cl::Buffer(
+                context_,
+                CL_MEM_WRITE_ONLY,
+                h_partials_.size() * sizeof(cl_double),
+                NULL,
+                &err),
+            err
+            );
+
+    for (cl::Kernel& kernel : kernels_) {
+        kernel.setArg(2, d_partials_);
+        kernel.setArg(3, cl::Local(5 * local_size_ * sizeof(cl_double)));
+    }
+
+    return CL_SUCCESS;
+}
+
+cl_int gpubench::DeviceVariance::reduce(
+        Method method,
+        cl::Buffer const& data,
+        cl_ulong n,
+        cl::Event& kernel_event,
+        cl::Event& read_event) {
+
+    cl::Kernel& kernel = kernels_[static_cast<int>(method)];
+
+    kernel.setArg(0, data);
+    kernel.setArg(1, n);
+
+    cle_sanitize_val_return(
+            commandqueue_.enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                cl::NDRange(num_groups_ * local_size_),
+                cl::NDRange(local_size_),
+                NULL,
+                &kernel_event));
+
+    cle_sanitize_val_return(
+            commandqueue_.enqueueReadBuffer(
+                d_partials_,
+                CL_FALSE,
+                0,
+                h_partials_.size() * sizeof(cl_double),
+                h_partials_.data(),
+                NULL,
+                &read_event));
+
+    return CL_SUCCESS;
+}
+
+GpuBench::Moments gpubench::DeviceVariance::moments(Method method) const {
+    GpuBench::Moments result = {0, 0, 0};
+
+    if (method == Method::Welford) {
+        for (size_t g = 0; g < num_groups_; ++g) {
+            GpuBench::Moments group = {
+                h_partials_[3 * g],
+                h_partials_[3 * g + 1],
+                h_partials_[3 * g + 2]
+            };
+            result = GpuBench::merge_moments(result, group);
+        }
+
+        return result;
+    }
+
+    // Sum and sum of squares, added with compensation for the Kahan method
+    double count = 0;
+    double sum = 0;
+    double c_sum = 0;
+    double squares = 0;
+    double c_squares = 0;
+
+    for (size_t g = 0; g < num_groups_; ++g) {
+        count += h_partials_[3 * g];
+
+        if (method == Method::Kahan) {
+            double y = h_partials_[3 * g + 1] - c_sum;
+            double t = sum + y;
+            c_sum = (t - sum) - y;
+            sum = t;
+
+            y = h_partials_[3 * g + 2] - c_squares;
+            t = squares + y;
+            c_squares = (t - squares) - y;
+            squares = t;
+        }
+        else {
+            sum += h_partials_[3 * g + 1];
+            squares += h_partials_[3 * g + 2];
+        }
+    }
+
+    if (count != 0) {
+        result.count = count;
+        result.mean = sum / count;
+        result.m2 = squares - sum * sum / count;
+    }
+
+    return result;
+}
@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef DEVICE_VARIANCE_HPP
+#define DEVICE_VARIANCE_HPP
+
+#include "common.hpp"
+
+#include <vector>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Work-group variance reductions of cl_kernels/variance.cl
+     * Needs a device with cl_khr_fp64.
+     */
+    class DeviceVariance {
+    public:
+        enum class Method {Naive, Kahan, Welford};
+
+        static int const num_methods = 3;
+        static Method const methods[num_methods];
+        static char const* method_name(Method method);
+
+        cl_int init(cl::Context context, cl::CommandQueue queue);
+
+        // Reduce the first n values of data and read back the partials
+        cl_int reduce(
+                Method method,
+                cl::Buffer const& data,
+                cl_ulong n,
+                cl::Event& kernel_event,
+                cl::Event& read_event);
+
+        // Merge the partials of the last reduction after read_event completed
+        GpuBench::Moments moments(Method method) const;
+
+    private:
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        std::vector<cl::Kernel> kernels_;
+        cl::Buffer d_partials_;
+        std::vector<cl_double> h_partials_;
+
+        size_t local_size_;
+        size_t num_groups_;
+    };
+}
+
+#endif /* DEVICE_VARIANCE_HPP */
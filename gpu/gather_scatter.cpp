@@ -0,0 +1,222 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "gather_scatter.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    size_t gcd(size_t a, size_t b) {
+        while (b != 0) {
+            size_t t = a % b;
+            a = b;
+            b = t;
+        }
+
+        return a;
+    }
+
+    /*
+     * Permutations of [0, n) with decreasing locality: identity, a fixed
+     * stride of at least one cache line, random within 4 KiB pages and
+     * fully random
+     */
+    void make_indices(int pattern, std::vector<cl_uint>& indices) {
+        size_t const n = indices.size();
+        size_t const page_elements = 4096 / sizeof(cl_uint);
+
+        std::iota(indices.begin(), indices.end(), 0);
+        std::mt19937 generator(42);
+
+        switch (pattern) {
+            case 0:
+                break;
+            case 1:
+                {
+                    size_t stride = 17;
+                    while (gcd(stride, n) != 1) {
+                        ++stride;
+                    }
+                    for (size_t i = 0; i < n; ++i) {
+                        indices[i] = (cl_uint) (i * stride % n);
+                    }
+                }
+                break;
+            case 2:
+                for (size_t begin = 0; begin < n; begin += page_elements) {
+                    std::shuffle(
+                            indices.begin() + begin,
+                            indices.begin() + std::min(n, begin + page_elements),
+                            generator);
+                }
+                break;
+            case 3:
+                std::shuffle(indices.begin(), indices.end(), generator);
+                break;
+        }
+    }
+}
+
+void gpubench::GatherScatter::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::GatherScatter::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::GatherScatter::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::GatherScatter::run(size_t buffer_bytes, unsigned int repetitions) {
+
+    cl_int err;
+
+    size_t const global_size = 1 << 20;
+
+    int const num_patterns = 4;
+    char const* patterns[] = {"sequential", "strided", "random in page", "random"};
+
+    int const num_kernels = 2;
+    char const* kernels[] = {"gather", "scatter"};
+
+    size_t n = buffer_bytes / sizeof(cl_uint);
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "gather_scatter.cl",
+                NULL,
+                program
+                ));
+
+    std::vector<cl_uint> h_in(n);
+    std::iota(h_in.begin(), h_in.end(), 0);
+
+    cle::TypedBuffer<cl_uint> d_in(
+            context_,
+            CL_MEM_COPY_HOST_PTR | CL_MEM_READ_ONLY,
+            n,
+            h_in.data()
+            );
+
+    cle::TypedBuffer<cl_uint> d_indices(
+            context_,
+            CL_MEM_READ_ONLY,
+            n,
+            NULL
+            );
+
+    cle::TypedBuffer<cl_uint> d_out(
+            context_,
+            CL_MEM_READ_WRITE,
+            n,
+            NULL
+            );
+
+    profiler_->add_table(
+            "gather scatter",
+            {"kernel", "pattern", "elements", "bytes", "median (us)", "GB/s"});
+
+    std::vector<cl_uint> h_indices(n);
+    std::vector<cl_uint> h_out(n);
+
+    for (int p = 0; p < num_patterns; ++p) {
+        make_indices(p, h_indices);
+
+        cle_sanitize_val_return(
+                commandqueue_.enqueueWriteBuffer(
+                    d_indices,
+                    CL_TRUE,
+                    0,
+                    d_indices.bytes(),
+                    h_indices.data(),
+                    NULL,
+                    NULL));
+
+        for (int k = 0; k < num_kernels; ++k) {
+            cl::Kernel kernel;
+            cle_sanitize_ref_return(
+                    kernel = cl::Kernel(program, kernels[k], &err),
+                    err
+                    );
+            kernel.setArg(0, d_in);
+            kernel.setArg(1, d_indices);
+            kernel.setArg(2, d_out);
+            kernel.setArg(3, (cl_uint) n);
+
+            // Data read and written plus the index buffer
+            size_t bytes = 3 * n * sizeof(cl_uint);
+            GpuBench::Statistics time;
+            cle_sanitize_val_return(
+                    GpuBench::time_kernel(
+                        commandqueue_,
+                        kernel,
+                        cl::NDRange(std::min(global_size, n)),
+                        cl::NullRange,
+                        repetitions,
+                        *profiler_,
+                        std::string(kernels[k]) + " " + patterns[p],
+                        bytes,
+                        time));
+
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueReadBuffer(
+                        d_out,
+                        CL_TRUE,
+                        0,
+                        d_out.bytes(),
+                        h_out.data(),
+                        NULL,
+                        NULL));
+
+            // in[i] = i, so gather yields the indices and scatter their inverse
+            for (size_t i = 0; i < n; ++i) {
+                bool valid = (k == 0)
+                    ? h_out[i] == h_indices[i]
+                    : h_out[h_indices[i]] == i;
+                if (!valid) {
+                    std::cerr << "Wrong " << kernels[k] << " result for "
+                        << patterns[p] << " indices" << std::endl;
+                    return -1;
+                }
+            }
+
+            profiler_->add_row({
+                    kernels[k],
+                    patterns[p],
+                    n,
+                    bytes,
+                    time.median / 1000.0,
+                    time.median ? (double) bytes / time.median : 0
+                    });
+        }
+    }
+
+    return 1;
+}
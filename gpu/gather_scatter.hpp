@@ -0,0 +1,43 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef GATHER_SCATTER_HPP
+#define GATHER_SCATTER_HPP
+
+#include "profiler.hpp"
+
+#include <cstddef>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Gather and scatter bandwidth for index patterns from sequential to
+     * a random permutation
+     */
+    class GatherScatter {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        int run(size_t buffer_bytes, unsigned int repetitions);
+
+    private:
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+    };
+}
+
+#endif /* GATHER_SCATTER_HPP */
@@ -0,0 +1,195 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "gpu_mem_bandwidth.hpp"
+#include "common.hpp"
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+void gpubench::GpuMemBandwidth::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::GpuMemBandwidth::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::GpuMemBandwidth::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::GpuMemBandwidth::run(size_t buffer_bytes) {
+
+    cl_int err;
+
+    size_t buffer_size = buffer_bytes / sizeof(cl_float);
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    int const num_vector_widths = 5;
+    cl_uint const vector_widths[] = {1, 2, 4, 8, 16};
+
+    int const num_global_sizes = 6;
+    size_t const global_sizes[] = {
+        1 << 10, 1 << 12, 1 << 14, 1 << 16, 1 << 18, 1 << 20
+    };
+
+    int const num_patterns = 2;
+    char const* patterns[] = {"coalesced", "strided"};
+
+    int const num_kernels = 4;
+    char const* kernels[] = {"read", "write", "copy", "triad"};
+    // Bytes moved per element: triad reads two and writes one buffer
+    size_t const accesses[] = {1, 1, 2, 3};
+
+    cl_float const scalar = 3.0f;
+    cl_float const never_flag = -1.0f;
+
+    std::vector<cl_float> h_buffer(buffer_size, 1.0f);
+
+    cle::TypedBuffer<cl_float> d_a(
+            context_,
+            CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE,
+            buffer_size,
+            h_buffer.data()
+            );
+
+    cle::TypedBuffer<cl_float> d_b(
+            context_,
+            CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE,
+            buffer_size,
+            h_buffer.data()
+            );
+
+    cle::TypedBuffer<cl_float> d_c(
+            context_,
+            CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE,
+            buffer_size,
+            h_buffer.data()
+            );
+
+    profiler_->add_table(
+            "gpu memory bandwidth",
+            {"kernel", "pattern", "vector width", "global size",
+            "bytes", "time (us)", "GB/s"});
+
+    for (int w = 0; w < num_vector_widths; ++w) {
+        cl::Program program;
+        std::stringstream options;
+        options << "-DVEC_WIDTH=" << vector_widths[w];
+
+        cle_sanitize_val_return(
+                GpuBench::build_program(
+                    context_,
+                    device,
+                    "mem_bandwidth.cl",
+                    options.str().c_str(),
+                    program
+                    ));
+
+        cl_uint num_elements = (cl_uint) (buffer_size / vector_widths[w]);
+
+        for (int k = 0; k < num_kernels; ++k) {
+            for (int p = 0; p < num_patterns; ++p) {
+                std::string name =
+                    std::string(kernels[k]) + "_" + patterns[p];
+
+                cl::Kernel kernel;
+                cle_sanitize_ref_return(
+                        kernel = cl::Kernel(program, name.c_str(), &err),
+                        err
+                        );
+
+                switch (k) {
+                    case 0:
+                        kernel.setArg(0, d_a);
+                        kernel.setArg(1, d_b);
+                        kernel.setArg(2, num_elements);
+                        kernel.setArg(3, never_flag);
+                        break;
+                    case 1:
+                        kernel.setArg(0, d_a);
+                        kernel.setArg(1, num_elements);
+                        kernel.setArg(2, scalar);
+                        break;
+                    case 2:
+                        kernel.setArg(0, d_b);
+                        kernel.setArg(1, d_a);
+                        kernel.setArg(2, num_elements);
+                        break;
+                    case 3:
+                        kernel.setArg(0, d_a);
+                        kernel.setArg(1, d_b);
+                        kernel.setArg(2, d_c);
+                        kernel.setArg(3, scalar);
+                        kernel.setArg(4, num_elements);
+                        break;
+                }
+
+                for (int g = 0; g < num_global_sizes; ++g) {
+                    if (global_sizes[g] > num_elements) {
+                        break;
+                    }
+
+                    cl::Event event;
+
+                    // Warm up
+                    cle_sanitize_val_return(
+                            commandqueue_.enqueueNDRangeKernel(
+                                kernel,
+                                cl::NullRange,
+                                cl::NDRange(global_sizes[g]),
+                                cl::NullRange,
+                                NULL,
+                                NULL));
+
+                    cle_sanitize_val_return(
+                            commandqueue_.enqueueNDRangeKernel(
+                                kernel,
+                                cl::NullRange,
+                                cl::NDRange(global_sizes[g]),
+                                cl::NullRange,
+                                NULL,
+                                &event));
+
+                    size_t bytes = accesses[k] * buffer_size * sizeof(cl_float);
+
+                    profiler_->add_event(name, event, bytes);
+                    cle_sanitize_val_return(
+                            profiler_->collect(commandqueue_));
+
+                    uint64_t duration =
+                        profiler_->last_records(1).front().execution_time();
+
+                    profiler_->add_row({
+                            kernels[k],
+                            patterns[p],
+                            vector_widths[w],
+                            global_sizes[g],
+                            bytes,
+                            duration / 1000.0,
+                            duration ? (double) bytes / duration : 0
+                            });
+                }
+            }
+        }
+    }
+
+    return 1;
+}
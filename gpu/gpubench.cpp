@@ -7,9 +7,28 @@
  * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
  */
 
+#include "atomics.hpp"
+#include "gather_scatter.hpp"
+#include "gpu_mem_bandwidth.hpp"
+#include "host_mem_bandwidth.hpp"
+#include "hybrid_variance.hpp"
+#include "launch_overhead.hpp"
+#include "local_memory.hpp"
 #include "pci_bandwidth.hpp"
+#include "pinned_allocation.hpp"
+#include "profiler.hpp"
+#include "program_cache.hpp"
+#include "startup_time.hpp"
+#include "streaming.hpp"
+#include "transfer_overlap.hpp"
+#include "variance_offload.hpp"
+#include "zero_copy.hpp"
 
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <clext.hpp>
 #include <boost/program_options.hpp>
@@ -22,7 +41,23 @@ namespace po = boost::program_options;
 
 class CmdOptions {
 public:
-    enum class Mode {GpuMemBandwidth, PciBandwidth};
+    enum class Mode {
+        None,
+        GpuMemBandwidth,
+        PciBandwidth,
+        TransferOverlap,
+        ZeroCopy,
+        Streaming,
+        VarianceOffload,
+        LaunchOverhead,
+        StartupTime,
+        HostMemBandwidth,
+        PinnedAllocation,
+        LocalMemory,
+        Atomics,
+        GatherScatter,
+        HybridVariance
+    };
 
     int parse(int argc, char **argv) {
         char help_msg[] =
@@ -39,11 +74,46 @@ public:
             ("device",
              po::value<unsigned int>(&device_)->default_value(0),
              "OpenCL device number")
+            ("alldevices", "Run on every device of every platform, one after the other")
+            ("concurrent", "Run on every device of every platform at the same time")
             ("gpumembw", "GPU Memory Bandwidth")
             ("pcibw", "PCI Bandwidth")
+            ("overlap", "Overlap of H2D, D2H and compute on multiple queues")
+            ("zerocopy", "Zero-copy, mapped and SVM access versus explicit copies")
+            ("streaming", "Chunked, pipelined host-to-device streaming")
+            ("variance", "Device variance reductions versus CPU kernels")
+            ("launch", "Kernel launch and command queue overhead")
+            ("startup", "Program build time from source and from the program cache")
+            ("hostmembw", "Host memory bandwidth, STREAM copy, scale, add and triad")
+            ("pinned", "Pinned buffer allocation cost and pinned pool savings")
+            ("localmem", "Local memory bandwidth with strided access")
+            ("atomics", "Global and local atomic throughput under contention")
+            ("gather", "Gather and scatter bandwidth for index patterns")
+            ("hybrid", "Variance reduced by host threads and the device together")
             ("buffersize",
              po::value<size_t>(&buffer_size_)->default_value(256),
              "Buffer size in MiB")
+            ("chunksize",
+             po::value<size_t>(&chunk_size_)->default_value(0),
+             "Streaming chunk size in KiB, 0 sweeps chunk sizes")
+            ("inflight",
+             po::value<unsigned int>(&in_flight_)->default_value(2),
+             "Streaming chunks in flight, e.g. 2 for double buffering")
+            ("repeat",
+             po::value<unsigned int>(&repetitions_)->default_value(10),
+             "Repetitions of each measurement")
+            ("threads",
+             po::value<unsigned int>(&threads_)->default_value(0),
+             "Host threads, 0 uses all hardware threads")
+            ("format",
+             po::value<std::string>(&format_)->default_value("csv"),
+             "Output format, csv or json")
+            ("events", "Also print every profiled event")
+            ("cachedir",
+             po::value<std::string>(&cache_dir_)->default_value(
+                 gpubench::ProgramCache::default_directory()),
+             "Program binary cache directory")
+            ("nocache", "Always build programs from source")
             ;
 
         po::variables_map vm;
@@ -65,18 +135,133 @@ public:
             device_ = vm["device"].as<unsigned int>();
         }
 
+        mode_ = Mode::None;
+
         if (vm.count("gpumembw")) {
             mode_ = Mode::GpuMemBandwidth;
+            mode_name_ = "gpumembw";
         }
 
         if (vm.count("pcibw")) {
             mode_ = Mode::PciBandwidth;
+            mode_name_ = "pcibw";
+        }
+
+        if (vm.count("overlap")) {
+            mode_ = Mode::TransferOverlap;
+            mode_name_ = "overlap";
+        }
+
+        if (vm.count("zerocopy")) {
+            mode_ = Mode::ZeroCopy;
+            mode_name_ = "zerocopy";
+        }
+
+        if (vm.count("streaming")) {
+            mode_ = Mode::Streaming;
+            mode_name_ = "streaming";
+        }
+
+        if (vm.count("variance")) {
+            mode_ = Mode::VarianceOffload;
+            mode_name_ = "variance";
+        }
+
+        if (vm.count("launch")) {
+            mode_ = Mode::LaunchOverhead;
+            mode_name_ = "launch";
+        }
+
+        if (vm.count("startup")) {
+            mode_ = Mode::StartupTime;
+            mode_name_ = "startup";
+        }
+
+        if (vm.count("hostmembw")) {
+            mode_ = Mode::HostMemBandwidth;
+            mode_name_ = "hostmembw";
+        }
+
+        if (vm.count("pinned")) {
+            mode_ = Mode::PinnedAllocation;
+            mode_name_ = "pinned";
+        }
+
+        if (vm.count("localmem")) {
+            mode_ = Mode::LocalMemory;
+            mode_name_ = "localmem";
+        }
+
+        if (vm.count("atomics")) {
+            mode_ = Mode::Atomics;
+            mode_name_ = "atomics";
+        }
+
+        if (vm.count("gather")) {
+            mode_ = Mode::GatherScatter;
+            mode_name_ = "gather";
+        }
+
+        if (vm.count("hybrid")) {
+            mode_ = Mode::HybridVariance;
+            mode_name_ = "hybrid";
+        }
+
+        if (mode_ == Mode::None) {
+            std::cerr << "No mode selected, see --help" << std::endl;
+            return -1;
         }
 
         if (vm.count("buffersize")) {
             buffer_size_ = vm["buffersize"].as<size_t>();
         }
 
+        if (vm.count("chunksize")) {
+            chunk_size_ = vm["chunksize"].as<size_t>();
+        }
+
+        if (vm.count("inflight")) {
+            in_flight_ = vm["inflight"].as<unsigned int>();
+        }
+
+        if (vm.count("repeat")) {
+            repetitions_ = vm["repeat"].as<unsigned int>();
+        }
+
+        if (vm.count("threads")) {
+            threads_ = vm["threads"].as<unsigned int>();
+        }
+
+        if (vm.count("format")) {
+            format_ = vm["format"].as<std::string>();
+            if (format_ != "csv" && format_ != "json") {
+                std::cerr << "Unknown output format " << format_ << std::endl;
+                return -1;
+            }
+        }
+
+        events_ = vm.count("events") != 0;
+
+        if (vm.count("cachedir")) {
+            cache_dir_ = vm["cachedir"].as<std::string>();
+        }
+
+        if (vm.count("nocache")) {
+            cache_dir_.clear();
+        }
+        concurrent_ = vm.count("concurrent") != 0;
+        all_devices_ = concurrent_ || vm.count("alldevices") != 0;
+
+        // Host thread teams pin to the same CPUs in every device thread
+        if (concurrent_
+                && (mode_ == Mode::HostMemBandwidth
+                    || mode_ == Mode::HybridVariance)) {
+            std::cerr << "Mode " << mode_name_
+                << " uses host threads and cannot run with --concurrent,"
+                << " use --alldevices instead" << std::endl;
+            return -1;
+        }
+
         return 1;
     }
 
@@ -84,6 +269,10 @@ public:
         return mode_;
     }
 
+    std::string const& mode_name() const {
+        return mode_name_;
+    }
+
     unsigned int cl_platform() const {
         return platform_;
     }
@@ -96,13 +285,466 @@ public:
         return buffer_size_ * 1024 * 1024;
     }
 
+    size_t chunk_bytes() const {
+        return chunk_size_ * 1024;
+    }
+
+    unsigned int in_flight() const {
+        return in_flight_;
+    }
+
+    unsigned int repetitions() const {
+        return repetitions_;
+    }
+
+    unsigned int threads() const {
+        return threads_;
+    }
+
+    gpubench::Profiler::Format format() const {
+        return format_ == "json"
+            ? gpubench::Profiler::Format::Json
+            : gpubench::Profiler::Format::Csv;
+    }
+
+    bool events() const {
+        return events_;
+    }
+
+    std::string const& cache_dir() const {
+        return cache_dir_;
+    }
+
+    bool all_devices() const {
+        return all_devices_;
+    }
+
+    bool concurrent() const {
+        return concurrent_;
+    }
+
 private:
     Mode mode_;
+    std::string mode_name_;
     unsigned int platform_;
     unsigned int device_;
     size_t buffer_size_;
+    size_t chunk_size_;
+    unsigned int in_flight_;
+    unsigned int repetitions_;
+    unsigned int threads_;
+    std::string format_;
+    bool events_;
+    std::string cache_dir_;
+    bool all_devices_;
+    bool concurrent_;
 };
 
+/*
+ * Run the selected mode on one device
+ */
+int run_mode(
+        CmdOptions const& options,
+        cl::Context const& context,
+        cl::CommandQueue const& queue,
+        gpubench::Profiler& profiler,
+        gpubench::ProgramCache& cache) {
+
+    int ret = 0;
+
+    switch (options.get_mode()) {
+        case CmdOptions::Mode::None:
+            return -1;
+        case CmdOptions::Mode::GpuMemBandwidth:
+            {
+                gpubench::GpuMemBandwidth gpumembw;
+                gpumembw.set_cl_context(context);
+                gpumembw.set_cl_commandqueue(queue);
+                gpumembw.set_profiler(profiler);
+
+                ret = gpumembw.run(options.buffer_bytes());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::PciBandwidth:
+            {
+                gpubench::PciBandwidth pcibw;
+                pcibw.set_cl_context(context);
+                pcibw.set_cl_commandqueue(queue);
+                pcibw.set_profiler(profiler);
+
+                ret = pcibw.run(options.buffer_bytes(), options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::TransferOverlap:
+            {
+                gpubench::TransferOverlap overlap;
+                overlap.set_cl_context(context);
+                overlap.set_cl_commandqueue(queue);
+                overlap.set_profiler(profiler);
+
+                ret = overlap.run(options.buffer_bytes(), options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::ZeroCopy:
+            {
+                gpubench::ZeroCopy zerocopy;
+                zerocopy.set_cl_context(context);
+                zerocopy.set_cl_commandqueue(queue);
+                zerocopy.set_profiler(profiler);
+
+                ret = zerocopy.run(options.buffer_bytes(), options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::Streaming:
+            {
+                gpubench::Streaming streaming;
+                streaming.set_cl_context(context);
+                streaming.set_cl_commandqueue(queue);
+                streaming.set_profiler(profiler);
+
+                ret = streaming.run(
+                        options.buffer_bytes(),
+                        options.chunk_bytes(),
+                        options.in_flight(),
+                        options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::VarianceOffload:
+            {
+                gpubench::VarianceOffload variance;
+                variance.set_cl_context(context);
+                variance.set_cl_commandqueue(queue);
+                variance.set_profiler(profiler);
+
+                ret = variance.run(options.buffer_bytes(), options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::LaunchOverhead:
+            {
+                gpubench::LaunchOverhead launch;
+                launch.set_cl_context(context);
+                launch.set_cl_commandqueue(queue);
+                launch.set_profiler(profiler);
+
+                ret = launch.run(options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::StartupTime:
+            {
+                gpubench::StartupTime startup;
+                startup.set_cl_context(context);
+                startup.set_cl_commandqueue(queue);
+                startup.set_profiler(profiler);
+                startup.set_program_cache(cache);
+
+                ret = startup.run(options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::HostMemBandwidth:
+            {
+                gpubench::HostMemBandwidth hostmembw;
+                hostmembw.set_profiler(profiler);
+
+                ret = hostmembw.run(
+                        options.buffer_bytes(),
+                        options.repetitions(),
+                        options.threads());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::PinnedAllocation:
+            {
+                gpubench::PinnedAllocation pinned;
+                pinned.set_cl_context(context);
+                pinned.set_cl_commandqueue(queue);
+                pinned.set_profiler(profiler);
+
+                ret = pinned.run(options.buffer_bytes(), options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::LocalMemory:
+            {
+                gpubench::LocalMemory localmem;
+                localmem.set_cl_context(context);
+                localmem.set_cl_commandqueue(queue);
+                localmem.set_profiler(profiler);
+
+                ret = localmem.run(options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::Atomics:
+            {
+                gpubench::Atomics atomics;
+                atomics.set_cl_context(context);
+                atomics.set_cl_commandqueue(queue);
+                atomics.set_profiler(profiler);
+
+                ret = atomics.run(options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::GatherScatter:
+            {
+                gpubench::GatherScatter gather;
+                gather.set_cl_context(context);
+                gather.set_cl_commandqueue(queue);
+                gather.set_profiler(profiler);
+
+                ret = gather.run(options.buffer_bytes(), options.repetitions());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+        case CmdOptions::Mode::HybridVariance:
+            {
+                gpubench::HybridVariance hybrid;
+                hybrid.set_cl_context(context);
+                hybrid.set_cl_commandqueue(queue);
+                hybrid.set_profiler(profiler);
+
+                ret = hybrid.run(
+                        options.buffer_bytes(),
+                        options.repetitions(),
+                        options.threads());
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            break;
+    }
+
+    return 1;
+}
+
+/*
+ * Run the selected mode on every device of every platform, either one
+ * device after the other or all at once with one host thread, context
+ * and queue per device. Each device reports into its own profiler, the
+ * results are merged with per-device prefixes and aggregated.
+ */
+int run_all_devices(
+        CmdOptions const& options,
+        gpubench::Profiler& profiler,
+        gpubench::ProgramCache& cache) {
+
+    cl_int err;
+
+    std::vector<cl::Platform> platforms;
+    cle_sanitize_val_return(
+            cl::Platform::get(&platforms));
+
+    std::vector<cl::Device> devices;
+    std::vector<unsigned int> platform_ids;
+    for (unsigned int p = 0; p < platforms.size(); ++p) {
+        std::vector<cl::Device> platform_devices;
+        err = platforms[p].getDevices(CL_DEVICE_TYPE_ALL, &platform_devices);
+        if (err != CL_SUCCESS) {
+            continue;
+        }
+
+        for (cl::Device const& device : platform_devices) {
+            devices.push_back(device);
+            platform_ids.push_back(p);
+        }
+    }
+
+    std::vector<cl::Context> contexts(devices.size());
+    std::vector<cl::CommandQueue> queues(devices.size());
+    std::vector<gpubench::Profiler> runs(devices.size());
+    std::vector<int> results(devices.size(), 0);
+    std::vector<std::string> setup_errors(devices.size());
+    std::vector<uint64_t> wall_times(devices.size(), 0);
+
+    // A device without a context or profiling queue fails on its own,
+    // the others still run
+    for (size_t d = 0; d < devices.size(); ++d) {
+        contexts[d] = cl::Context(devices[d], NULL, NULL, NULL, &err);
+        if (err != CL_SUCCESS) {
+            setup_errors[d] = "cannot create context, error " + std::to_string(err);
+        }
+        else {
+            queues[d] = cl::CommandQueue(
+                    contexts[d],
+                    devices[d],
+                    CL_QUEUE_PROFILING_ENABLE,
+                    &err);
+            if (err != CL_SUCCESS) {
+                setup_errors[d] =
+                    "cannot create profiling queue, error " + std::to_string(err);
+            }
+        }
+
+        if (!setup_errors[d].empty()) {
+            std::cerr << "Device " << d << ": " << setup_errors[d] << std::endl;
+            results[d] = -1;
+        }
+    }
+
+    auto run_device = [&](size_t d) {
+        if (!setup_errors[d].empty()) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+
+        runs[d].set_device(devices[d]);
+        results[d] = run_mode(options, contexts[d], queues[d], runs[d], cache);
+
+        std::chrono::steady_clock::time_point end =
+            std::chrono::steady_clock::now();
+        wall_times[d] =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    };
+
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+
+    if (options.concurrent()) {
+        std::vector<std::thread> threads;
+        for (size_t d = 0; d < devices.size(); ++d) {
+            threads.push_back(std::thread(run_device, d));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    else {
+        for (size_t d = 0; d < devices.size(); ++d) {
+            run_device(d);
+        }
+    }
+
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    uint64_t total_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    profiler.add_metadata("devices", std::to_string(devices.size()));
+    profiler.add_metadata("concurrent", options.concurrent() ? "yes" : "no");
+    profiler.add_metadata("total time (ms)", std::to_string(total_time / 1000000.0));
+    for (size_t d = 0; d < devices.size(); ++d) {
+        if (!setup_errors[d].empty()) {
+            profiler.add_metadata(
+                    "device " + std::to_string(d) + " failed",
+                    setup_errors[d]);
+        }
+    }
+
+    profiler.add_table(
+            "devices",
+            {"device", "platform", "platform name", "device name",
+            "device type", "status", "wall time (ms)"});
+
+    std::vector<gpubench::Profiler> completed;
+    bool failed = false;
+    for (size_t d = 0; d < devices.size(); ++d) {
+        cl_device_type type = devices[d].getInfo<CL_DEVICE_TYPE>();
+        std::string platform_name = platforms[platform_ids[d]].getInfo<CL_PLATFORM_NAME>();
+        std::string device_name = devices[d].getInfo<CL_DEVICE_NAME>();
+
+        profiler.add_row({
+                d,
+                platform_ids[d],
+                platform_name.substr(0, platform_name.find('\0')),
+                device_name.substr(0, device_name.find('\0')),
+                (type & CL_DEVICE_TYPE_GPU) ? "GPU"
+                : (type & CL_DEVICE_TYPE_CPU) ? "CPU"
+                : (type & CL_DEVICE_TYPE_ACCELERATOR) ? "accelerator"
+                : "other",
+                (results[d] < 0) ? "failed" : "ok",
+                wall_times[d] / 1000000.0
+                });
+
+        if (results[d] < 0) {
+            failed = true;
+        }
+        else {
+            completed.push_back(runs[d]);
+        }
+    }
+
+    for (size_t d = 0; d < devices.size(); ++d) {
+        if (results[d] >= 0) {
+            profiler.append(runs[d], "device " + std::to_string(d) + ": ");
+        }
+    }
+
+    if (completed.size() > 1) {
+        profiler.add_aggregate(completed);
+    }
+
+    return failed ? -1 : 1;
+}
+
+/*
+ * Program cache hits and the time spent building programs
+ */
+void add_cache_metadata(
+        gpubench::Profiler& profiler,
+        gpubench::ProgramCache const& cache) {
+    gpubench::ProgramCache::Statistics stats = cache.statistics();
+
+    profiler.add_metadata(
+            "program cache",
+            cache.directory().empty() ? "disabled" : cache.directory());
+    profiler.add_metadata("program cache hits", std::to_string(stats.hits));
+    profiler.add_metadata("program cache misses", std::to_string(stats.misses));
+    profiler.add_metadata("program cache rejected", std::to_string(stats.rejected));
+    profiler.add_metadata(
+            "program build time (ms)",
+            std::to_string(stats.build_time / 1000000.0));
+}
+
 int main(int argc, char **argv) {
 
     int ret = 0;
@@ -114,30 +756,51 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    gpubench::Profiler profiler;
+    profiler.add_metadata("mode", options.mode_name());
+    profiler.add_metadata("buffer bytes", std::to_string(options.buffer_bytes()));
+    profiler.add_metadata("repetitions", std::to_string(options.repetitions()));
+
+    gpubench::ProgramCache cache;
+    cache.set_directory(options.cache_dir());
+    GpuBench::set_program_cache(&cache);
+
+    if (options.all_devices()) {
+        ret = run_all_devices(options, profiler, cache);
+        add_cache_metadata(profiler, cache);
+        profiler.print(std::cout, options.format(), options.events());
+
+        return (ret < 0) ? 1 : 0;
+    }
+
     cle::CLInitializer initializer;
     if (initializer.init(options.cl_platform(), options.cl_device()) < 0) {
         return 1;
     }
-    cle_sanitize_done_return(
-            initializer.print_device_info()
-            );
 
-    switch (options.get_mode()) {
-        case CmdOptions::Mode::GpuMemBandwidth:
-
-            break;
-        case CmdOptions::Mode::PciBandwidth:
-            gpubench::PciBandwidth pcibw;
-            pcibw.set_cl_context(initializer.get_context());
-            pcibw.set_cl_commandqueue(initializer.get_commandqueue());
+    // JSON output must stay parseable, the device is part of its metadata
+    if (options.format() == gpubench::Profiler::Format::Csv) {
+        cle_sanitize_done_return(
+                initializer.print_device_info()
+                );
+    }
 
-            ret = pcibw.run(options.buffer_bytes());
-            if (ret < 0) {
-                return 1;
-            }
+    profiler.set_device(
+            initializer.get_commandqueue().getInfo<CL_QUEUE_DEVICE>());
 
-            break;
+    ret = run_mode(
+            options,
+            initializer.get_context(),
+            initializer.get_commandqueue(),
+            profiler,
+            cache);
+    if (ret < 0) {
+        return 1;
     }
 
+    add_cache_metadata(profiler, cache);
+
+    profiler.print(std::cout, options.format(), options.events());
+
     return 0;
 }
@@ -0,0 +1,228 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "host_mem_bandwidth.hpp"
+#include "common.hpp"
+#include "thread_team.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Doubles per 64 byte cache line, threads work on whole lines
+    size_t const line_elements = 8;
+
+    double const scalar = 3.0;
+
+    enum Kernel {Copy, Scale, Add, Triad};
+
+    /*
+     * c = a, b = scalar * c, c = a + b or a = b + scalar * c on [begin, end)
+     *
+     * Stores bypass the caches, as every array is much larger than the
+     * last level cache.
+     */
+    void stream_kernel(
+            Kernel kernel,
+            double *a,
+            double *b,
+            double *c,
+            size_t begin,
+            size_t end) {
+        size_t i = begin;
+
+#ifdef __SSE2__
+        __m128d const s = _mm_set1_pd(scalar);
+
+        switch (kernel) {
+            case Copy:
+                for (; i + 2 <= end; i += 2) {
+                    _mm_stream_pd(&c[i], _mm_load_pd(&a[i]));
+                }
+                break;
+            case Scale:
+                for (; i + 2 <= end; i += 2) {
+                    _mm_stream_pd(&b[i], _mm_mul_pd(s, _mm_load_pd(&c[i])));
+                }
+                break;
+            case Add:
+                for (; i + 2 <= end; i += 2) {
+                    _mm_stream_pd(
+                            &c[i],
+                            _mm_add_pd(_mm_load_pd(&a[i]), _mm_load_pd(&b[i])));
+                }
+                break;
+            case Triad:
+                for (; i + 2 <= end; i += 2) {
+                    _mm_stream_pd(
+                            &a[i],
+                            _mm_add_pd(
+                                _mm_load_pd(&b[i]),
+                                _mm_mul_pd(s, _mm_load_pd(&c[i]))));
+                }
+                break;
+        }
+        _mm_sfence();
+#endif
+
+        for (; i < end; ++i) {
+            switch (kernel) {
+                case Copy:
+                    c[i] = a[i];
+                    break;
+                case Scale:
+                    b[i] = scalar * c[i];
+                    break;
+                case Add:
+                    c[i] = a[i] + b[i];
+                    break;
+                case Triad:
+                    a[i] = b[i] + scalar * c[i];
+                    break;
+            }
+        }
+    }
+
+    bool check(double expected, double value) {
+        return std::fabs(value - expected) <= 1e-13 * std::fabs(expected);
+    }
+}
+
+void gpubench::HostMemBandwidth::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::HostMemBandwidth::run(
+        size_t buffer_bytes,
+        unsigned int repetitions,
+        unsigned int threads) {
+
+    int const num_kernels = 4;
+    Kernel const kernels[] = {Copy, Scale, Add, Triad};
+    char const* names[] = {"host copy", "host scale", "host add", "host triad"};
+    // Arrays read and written by each kernel
+    int const arrays[] = {2, 2, 3, 3};
+
+    size_t n = buffer_bytes / sizeof(double);
+
+    // posix_memalign leaves the pages untouched until the first touch below
+    double *a = NULL;
+    double *b = NULL;
+    double *c = NULL;
+    if (posix_memalign((void **) &a, 64, n * sizeof(double)) != 0
+            || posix_memalign((void **) &b, 64, n * sizeof(double)) != 0
+            || posix_memalign((void **) &c, 64, n * sizeof(double)) != 0) {
+        std::cerr << "Cannot allocate host arrays" << std::endl;
+        free(a);
+        free(b);
+        free(c);
+        return -1;
+    }
+
+    ThreadTeam team(threads);
+
+    auto slice = [&](unsigned int thread, size_t& begin, size_t& end) {
+        ThreadTeam::partition(n, team.size(), thread, line_elements, begin, end);
+    };
+
+    // Also the first touch, so each thread's pages are local to it
+    auto reset = [&](unsigned int thread) {
+        size_t begin, end;
+        slice(thread, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            a[i] = 1.0;
+            b[i] = 2.0;
+            c[i] = 0.0;
+        }
+    };
+
+    team.run(reset);
+
+    std::vector<std::vector<uint64_t>> times(num_kernels);
+
+    for (unsigned int r = 0; r < repetitions; ++r) {
+        // Scale and triad grow the values by 15 per repetition, which
+        // overflows after a few hundred, so every repetition starts over
+        if (r > 0) {
+            team.run(reset);
+        }
+
+        for (int k = 0; k < num_kernels; ++k) {
+            std::chrono::steady_clock::time_point begin =
+                std::chrono::steady_clock::now();
+
+            team.run([&](unsigned int thread) {
+                    size_t begin, end;
+                    slice(thread, begin, end);
+                    stream_kernel(kernels[k], a, b, c, begin, end);
+                    });
+
+            std::chrono::steady_clock::time_point end =
+                std::chrono::steady_clock::now();
+            times[k].push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        end - begin).count());
+        }
+    }
+
+    // Replay the kernels on scalars and compare, as STREAM does
+    double aj = 1.0;
+    double bj = 2.0;
+    double cj = 0.0;
+    if (repetitions > 0) {
+        cj = aj;
+        bj = scalar * cj;
+        cj = aj + bj;
+        aj = bj + scalar * cj;
+    }
+
+    bool valid = true;
+    for (size_t i = 0; i < n && valid; i += 4096) {
+        valid = check(aj, a[i]) && check(bj, b[i]) && check(cj, c[i]);
+    }
+
+    free(a);
+    free(b);
+    free(c);
+
+    if (!valid) {
+        std::cerr << "Host memory bandwidth results failed validation" << std::endl;
+        return -1;
+    }
+
+    profiler_->add_metadata("host threads", std::to_string(team.size()));
+    profiler_->add_table(
+            "host memory bandwidth",
+            {"transfer", "bytes", "min (us)", "median (us)", "p99 (us)", "GB/s"});
+
+    for (int k = 0; k < num_kernels; ++k) {
+        size_t bytes = arrays[k] * n * sizeof(double);
+        GpuBench::Statistics stats = GpuBench::statistics(times[k]);
+
+        profiler_->add_row({
+                names[k],
+                bytes,
+                stats.min / 1000.0,
+                stats.median / 1000.0,
+                stats.p99 / 1000.0,
+                stats.median ? (double) bytes / stats.median : 0
+                });
+    }
+
+    return 1;
+}
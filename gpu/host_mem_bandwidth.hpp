@@ -0,0 +1,37 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef HOST_MEM_BANDWIDTH_HPP
+#define HOST_MEM_BANDWIDTH_HPP
+
+#include "profiler.hpp"
+
+#include <cstddef>
+
+namespace gpubench {
+    /*
+     * STREAM copy, scale, add and triad on host memory
+     *
+     * Each array is as large as the device buffers. Every thread first
+     * touches the part of the arrays it later works on, so that pages
+     * are local to its NUMA node.
+     */
+    class HostMemBandwidth {
+    public:
+        void set_profiler(Profiler& profiler);
+
+        // 0 threads uses all hardware threads
+        int run(size_t buffer_bytes, unsigned int repetitions, unsigned int threads);
+
+    private:
+        Profiler *profiler_;
+    };
+}
+
+#endif /* HOST_MEM_BANDWIDTH_HPP */
@@ -0,0 +1,386 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "hybrid_variance.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <clext.hpp>
+
+#include <cle_math.h>
+#include <datagen.h>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    // Host blocks stay in L2, so the mean and the variance pass over a
+    // block only read it from memory once
+    size_t const block_elements = 32 * 1024;
+
+    // Device transfers of 32 MiB, dynamic chunks of 8 MiB
+    size_t const device_chunk_elements = 4 * 1024 * 1024;
+    size_t const dynamic_chunk_elements = 1024 * 1024;
+
+    gpubench::DeviceVariance::Method const device_method =
+        gpubench::DeviceVariance::Method::Welford;
+
+    uint64_t elapsed_nanoseconds(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+    }
+
+    /*
+     * Moments of x with the cle_math kernels, block by block. The SSE4.1
+     * kernel needs 16 byte aligned input of even length, x is aligned.
+     */
+    GpuBench::Moments host_moments(double const* x, size_t n) {
+        GpuBench::Moments result = {0, 0, 0};
+
+        for (size_t begin = 0; begin < n; begin += block_elements) {
+            size_t size = std::min(block_elements, n - begin);
+            double const* block = x + begin;
+
+            double variance = (size % 2 == 0)
+                ? variance_onepass_kbn_sse4_1(block, size)
+                : variance_onepass_kbn(block, size);
+
+            GpuBench::Moments moments = {
+                (double) size,
+                mean(block, size),
+                variance * size
+            };
+            result = GpuBench::merge_moments(result, moments);
+        }
+
+        return result;
+    }
+}
+
+void gpubench::HybridVariance::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::HybridVariance::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::HybridVariance::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+/*
+ * Transfer x to the device in chunks and reduce each chunk there
+ */
+cl_int gpubench::HybridVariance::reduce_device(
+        double const* x,
+        size_t n,
+        GpuBench::Moments& moments) {
+
+    for (size_t begin = 0; begin < n; begin += device_chunk_elements) {
+        size_t size = std::min(device_chunk_elements, n - begin);
+        cl::Event kernel_event;
+        cl::Event read_event;
+
+        cle_sanitize_val_return(
+                commandqueue_.enqueueWriteBuffer(
+                    d_chunk_,
+                    CL_FALSE,
+                    0,
+                    size * sizeof(cl_double),
+                    x + begin,
+                    NULL,
+                    NULL));
+
+        cle_sanitize_val_return(
+                device_variance_.reduce(
+                    device_method,
+                    d_chunk_,
+                    size,
+                    kernel_event,
+                    read_event));
+
+        cle_sanitize_val_return(
+                read_event.wait());
+
+        moments = GpuBench::merge_moments(
+                moments,
+                device_variance_.moments(device_method));
+    }
+
+    return CL_SUCCESS;
+}
+
+/*
+ * The device reduces the first device_elements, the host threads split
+ * the rest evenly
+ */
+int gpubench::HybridVariance::run_static(
+        std::vector<double> const& x,
+        size_t device_elements,
+        ThreadTeam& team,
+        Split& split) {
+
+    size_t const host_elements = x.size() - device_elements;
+
+    std::vector<GpuBench::Moments> partials(team.size() + 1, {0, 0, 0});
+    cl_int device_err = CL_SUCCESS;
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::thread device_thread([&] {
+            if (device_elements != 0) {
+                device_err = reduce_device(
+                        x.data(),
+                        device_elements,
+                        partials[team.size()]);
+            }
+            split.device_time = elapsed_nanoseconds(begin);
+            });
+
+    team.run([&](unsigned int thread) {
+            size_t first, last;
+            ThreadTeam::partition(
+                    host_elements,
+                    team.size(),
+                    thread,
+                    block_elements,
+                    first,
+                    last);
+            partials[thread] = host_moments(
+                    x.data() + device_elements + first,
+                    last - first);
+            });
+    split.host_time = elapsed_nanoseconds(begin);
+
+    device_thread.join();
+    split.time = elapsed_nanoseconds(begin);
+
+    cle_sanitize_val_return(device_err);
+
+    split.device_elements = device_elements;
+    split.moments = {0, 0, 0};
+    for (GpuBench::Moments const& partial : partials) {
+        split.moments = GpuBench::merge_moments(split.moments, partial);
+    }
+
+    return 1;
+}
+
+/*
+ * Host threads and the device take chunks from a shared counter, so the
+ * faster side ends up with more of the input
+ */
+int gpubench::HybridVariance::run_dynamic(
+        std::vector<double> const& x,
+        ThreadTeam& team,
+        Split& split) {
+
+    size_t const n = x.size();
+    size_t const num_chunks = (n + dynamic_chunk_elements - 1) / dynamic_chunk_elements;
+
+    std::atomic<size_t> next_chunk(0);
+    std::vector<GpuBench::Moments> partials(team.size() + 1, {0, 0, 0});
+    cl_int device_err = CL_SUCCESS;
+    size_t device_chunks = 0;
+
+    auto take = [&](size_t& first, size_t& last) {
+        size_t chunk = next_chunk.fetch_add(1);
+        if (chunk >= num_chunks) {
+            return false;
+        }
+
+        first = chunk * dynamic_chunk_elements;
+        last = std::min(n, first + dynamic_chunk_elements);
+
+        return true;
+    };
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::thread device_thread([&] {
+            size_t first, last;
+            while (device_err == CL_SUCCESS && take(first, last)) {
+                device_err = reduce_device(
+                        x.data() + first,
+                        last - first,
+                        partials[team.size()]);
+                ++device_chunks;
+            }
+            split.device_time = elapsed_nanoseconds(begin);
+            });
+
+    team.run([&](unsigned int thread) {
+            size_t first, last;
+            while (take(first, last)) {
+                partials[thread] = GpuBench::merge_moments(
+                        partials[thread],
+                        host_moments(x.data() + first, last - first));
+            }
+            });
+    split.host_time = elapsed_nanoseconds(begin);
+
+    device_thread.join();
+    split.time = elapsed_nanoseconds(begin);
+
+    cle_sanitize_val_return(device_err);
+
+    split.device_elements = std::min(n, device_chunks * dynamic_chunk_elements);
+    split.moments = {0, 0, 0};
+    for (GpuBench::Moments const& partial : partials) {
+        split.moments = GpuBench::merge_moments(split.moments, partial);
+    }
+
+    return 1;
+}
+
+int gpubench::HybridVariance::run(
+        size_t buffer_bytes,
+        unsigned int repetitions,
+        unsigned int threads) {
+
+    cl_int err;
+    int ret;
+
+    int const num_shares = 11;
+
+    size_t const n = buffer_bytes / sizeof(cl_double);
+
+    cle_sanitize_val_return(
+            device_variance_.init(context_, commandqueue_));
+
+    cle_sanitize_ref_return(
+            d_chunk_ = cl::Buffer(
+                context_,
+                CL_MEM_READ_ONLY,
+                std::min(n, device_chunk_elements) * sizeof(cl_double),
+                NULL,
+                &err),
+            err
+            );
+
+    std::vector<double> x(n);
+    GpuBench::generate_dataset(0, x);
+    long double reference = GpuBench::reference_variance(x);
+
+    ThreadTeam team(threads);
+
+    profiler_->add_metadata("hybrid host threads", std::to_string(team.size()));
+    profiler_->add_metadata("hybrid dataset", datasets[0].name);
+    profiler_->add_metadata(
+            "hybrid device method",
+            DeviceVariance::method_name(device_method));
+    profiler_->add_table(
+            "hybrid variance",
+            {"strategy", "device share", "median (ms)", "GB/s",
+            "host GB/s", "device GB/s", "relative error"});
+
+    // Static shares from host only to device only, then dynamic
+    struct Result {
+        char const* strategy;
+        double share;
+        double throughput;
+    };
+    std::vector<Result> results;
+
+    for (int s = 0; s <= num_shares; ++s) {
+        bool dynamic = (s == num_shares);
+        double share = (double) s / (num_shares - 1);
+
+        size_t device_elements = n;
+        if (share < 1) {
+            device_elements = (size_t) (share * n) / block_elements * block_elements;
+        }
+
+        std::vector<Split> splits;
+
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            Split split = {{0, 0, 0}, 0, 0, 0, 0};
+            ret = dynamic
+                ? run_dynamic(x, team, split)
+                : run_static(x, device_elements, team, split);
+            if (ret < 0) {
+                return ret;
+            }
+
+            splits.push_back(split);
+        }
+
+        // Report the run with the median time as a whole, as the share of
+        // dynamic runs varies between repetitions
+        Split split = {{0, 0, 0}, 0, 0, 0, 0};
+        if (!splits.empty()) {
+            std::sort(
+                    splits.begin(),
+                    splits.end(),
+                    [](Split const& a, Split const& b) {
+                        return a.time < b.time;
+                    });
+            split = splits[(splits.size() - 1) / 2];
+        }
+
+        share = (double) split.device_elements / n;
+
+        uint64_t time = split.time;
+        double host_bytes = (double) (n - split.device_elements) * sizeof(cl_double);
+        double device_bytes = (double) split.device_elements * sizeof(cl_double);
+        double throughput = time ? (double) n * sizeof(cl_double) / time : 0;
+
+        profiler_->add_row({
+                dynamic ? "dynamic" : "static",
+                share,
+                time / 1000000.0,
+                throughput,
+                split.host_time ? host_bytes / split.host_time : 0,
+                split.device_time ? device_bytes / split.device_time : 0,
+                GpuBench::relative_error(
+                    split.moments.m2 / split.moments.count,
+                    reference)
+                });
+
+        results.push_back({dynamic ? "dynamic" : "static", share, throughput});
+    }
+
+    Result const& host_only = results.front();
+    Result const& device_only = results[num_shares - 1];
+    Result const& dynamic = results.back();
+    Result const& best_static = *std::max_element(
+            results.begin(),
+            results.end() - 1,
+            [](Result const& a, Result const& b) {
+                return a.throughput < b.throughput;
+            });
+
+    profiler_->add_table(
+            "hybrid variance best",
+            {"strategy", "device share", "GB/s",
+            "speedup over host only", "speedup over device only"});
+
+    for (Result const* result : {&best_static, &dynamic}) {
+        profiler_->add_row({
+                result->strategy,
+                result->share,
+                result->throughput,
+                host_only.throughput ? result->throughput / host_only.throughput : 0,
+                device_only.throughput ? result->throughput / device_only.throughput : 0
+                });
+    }
+
+    return 1;
+}
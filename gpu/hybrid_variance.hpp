@@ -0,0 +1,79 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef HYBRID_VARIANCE_HPP
+#define HYBRID_VARIANCE_HPP
+
+#include "common.hpp"
+#include "device_variance.hpp"
+#include "profiler.hpp"
+#include "thread_team.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Variance of one large array reduced by host threads and an OpenCL
+     * device at the same time
+     *
+     * The input is either split at a static ratio, or cut into chunks
+     * that host threads and the device take from a shared counter until
+     * none are left. Partial moments are merged on the host.
+     */
+    class HybridVariance {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        // 0 threads uses all hardware threads
+        int run(size_t buffer_bytes, unsigned int repetitions, unsigned int threads);
+
+    private:
+        struct Split {
+            GpuBench::Moments moments;
+            uint64_t time;
+            uint64_t host_time;
+            uint64_t device_time;
+            size_t device_elements;
+        };
+
+        cl_int reduce_device(
+                double const* x,
+                size_t n,
+                GpuBench::Moments& moments);
+
+        int run_static(
+                std::vector<double> const& x,
+                size_t device_elements,
+                ThreadTeam& team,
+                Split& split);
+
+        int run_dynamic(
+                std::vector<double> const& x,
+                ThreadTeam& team,
+                Split& split);
+
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+        DeviceVariance device_variance_;
+        cl::Buffer d_chunk_;
+    };
+}
+
+#endif /* HYBRID_VARIANCE_HPP */
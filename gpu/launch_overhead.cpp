@@ -0,0 +1,244 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "launch_overhead.hpp"
+#include "common.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    uint64_t host_nanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void add_latency_row(
+            gpubench::Profiler& profiler,
+            char const* name,
+            std::vector<uint64_t> const& samples) {
+        GpuBench::Statistics stats = GpuBench::statistics(samples);
+
+        profiler.add_row({
+                name,
+                stats.min / 1000.0,
+                stats.median / 1000.0,
+                stats.p99 / 1000.0
+                });
+    }
+}
+
+void gpubench::LaunchOverhead::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::LaunchOverhead::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::LaunchOverhead::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::LaunchOverhead::run(unsigned int repetitions) {
+
+    cl_int err;
+
+    int const num_batch_sizes = 4;
+    unsigned int const batch_sizes[] = {1, 10, 100, 1000};
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "empty.cl",
+                NULL,
+                program
+                ));
+
+    cl::Kernel kernel;
+    cle_sanitize_ref_return(
+            kernel = cl::Kernel(program, "empty", &err),
+            err
+            );
+
+    cle::TypedBuffer<cl_int> d_unused(
+            context_,
+            CL_MEM_READ_WRITE,
+            1,
+            NULL
+            );
+    kernel.setArg(0, d_unused);
+
+    std::vector<uint64_t> enqueue_times;
+    std::vector<uint64_t> enqueue_wait_times;
+    std::vector<uint64_t> enqueue_finish_times;
+    std::vector<uint64_t> wait_completed_times;
+    std::vector<uint64_t> finish_idle_times;
+    std::vector<uint64_t> queued_submit;
+    std::vector<uint64_t> submit_start;
+    std::vector<uint64_t> start_end;
+    std::vector<uint64_t> queued_end;
+
+    // Warm up
+    cle_sanitize_val_return(
+            commandqueue_.enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                cl::NDRange(1),
+                cl::NullRange,
+                NULL,
+                NULL));
+    cle_sanitize_val_return(
+            commandqueue_.finish());
+
+    for (unsigned int r = 0; r < repetitions; ++r) {
+        cl::Event event;
+        uint64_t begin, enqueued, end;
+
+        // Enqueue followed by event.wait()
+        begin = host_nanoseconds();
+        cle_sanitize_val_return(
+                commandqueue_.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NullRange,
+                    cl::NDRange(1),
+                    cl::NullRange,
+                    NULL,
+                    &event));
+        enqueued = host_nanoseconds();
+        cle_sanitize_val_return(
+                event.wait());
+        end = host_nanoseconds();
+
+        enqueue_times.push_back(enqueued - begin);
+        enqueue_wait_times.push_back(end - begin);
+
+        // event.wait() on an event that has already completed
+        begin = host_nanoseconds();
+        cle_sanitize_val_return(
+                event.wait());
+        end = host_nanoseconds();
+        wait_completed_times.push_back(end - begin);
+
+        profiler_->add_event("empty kernel", event);
+        cle_sanitize_val_return(
+                profiler_->collect(commandqueue_));
+        GpuBench::EventPhases phases = profiler_->last_records(1).front().phases;
+        queued_submit.push_back(phases.submit - phases.queued);
+        submit_start.push_back(phases.start - phases.submit);
+        start_end.push_back(phases.end - phases.start);
+        queued_end.push_back(phases.end - phases.queued);
+
+        // Enqueue followed by clFinish
+        begin = host_nanoseconds();
+        cle_sanitize_val_return(
+                commandqueue_.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NullRange,
+                    cl::NDRange(1),
+                    cl::NullRange,
+                    NULL,
+                    NULL));
+        cle_sanitize_val_return(
+                commandqueue_.finish());
+        end = host_nanoseconds();
+        enqueue_finish_times.push_back(end - begin);
+
+        // clFinish round trip on an idle queue
+        begin = host_nanoseconds();
+        cle_sanitize_val_return(
+                commandqueue_.finish());
+        end = host_nanoseconds();
+        finish_idle_times.push_back(end - begin);
+    }
+
+    profiler_->add_table(
+            "launch latency",
+            {"measurement", "min (us)", "median (us)", "p99 (us)"});
+    add_latency_row(*profiler_, "enqueue", enqueue_times);
+    add_latency_row(*profiler_, "enqueue + event wait", enqueue_wait_times);
+    add_latency_row(*profiler_, "enqueue + finish", enqueue_finish_times);
+    add_latency_row(*profiler_, "event wait on completed event", wait_completed_times);
+    add_latency_row(*profiler_, "finish on idle queue", finish_idle_times);
+    add_latency_row(*profiler_, "queued to submit", queued_submit);
+    add_latency_row(*profiler_, "submit to start", submit_start);
+    add_latency_row(*profiler_, "start to end", start_end);
+    add_latency_row(*profiler_, "queued to end", queued_end);
+
+    // Batches of launches without waiting in between
+    profiler_->add_table(
+            "launch batches",
+            {"batch size", "min total (us)", "median total (us)",
+            "p99 total (us)", "median per launch (us)", "launches/s",
+            "min queued to end of last launch (us)",
+            "median queued to end of last launch (us)",
+            "p99 queued to end of last launch (us)"});
+
+    for (int b = 0; b < num_batch_sizes; ++b) {
+        std::vector<uint64_t> batch_times;
+        std::vector<uint64_t> last_latencies;
+
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            cl::Event last_event;
+
+            uint64_t begin = host_nanoseconds();
+            for (unsigned int i = 0; i < batch_sizes[b]; ++i) {
+                cle_sanitize_val_return(
+                        commandqueue_.enqueueNDRangeKernel(
+                            kernel,
+                            cl::NullRange,
+                            cl::NDRange(1),
+                            cl::NullRange,
+                            NULL,
+                            (i == batch_sizes[b] - 1) ? &last_event : NULL));
+            }
+            cle_sanitize_val_return(
+                    commandqueue_.finish());
+            uint64_t end = host_nanoseconds();
+
+            profiler_->add_event("empty kernel batch", last_event);
+            cle_sanitize_val_return(
+                    profiler_->collect(commandqueue_));
+            GpuBench::EventPhases phases = profiler_->last_records(1).front().phases;
+
+            batch_times.push_back(end - begin);
+            last_latencies.push_back(phases.end - phases.queued);
+        }
+
+        GpuBench::Statistics batch = GpuBench::statistics(batch_times);
+        GpuBench::Statistics last = GpuBench::statistics(last_latencies);
+        double per_launch = (double) batch.median / batch_sizes[b];
+
+        profiler_->add_row({
+                batch_sizes[b],
+                batch.min / 1000.0,
+                batch.median / 1000.0,
+                batch.p99 / 1000.0,
+                per_launch / 1000.0,
+                per_launch > 0 ? 1e9 / per_launch : 0,
+                last.min / 1000.0,
+                last.median / 1000.0,
+                last.p99 / 1000.0
+                });
+    }
+
+    return 1;
+}
@@ -0,0 +1,37 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef LAUNCH_OVERHEAD_HPP
+#define LAUNCH_OVERHEAD_HPP
+
+#include "profiler.hpp"
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    class LaunchOverhead {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        int run(unsigned int repetitions);
+
+    private:
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+    };
+}
+
+#endif /* LAUNCH_OVERHEAD_HPP */
@@ -0,0 +1,126 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "local_memory.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+void gpubench::LocalMemory::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::LocalMemory::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::LocalMemory::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::LocalMemory::run(unsigned int repetitions) {
+
+    cl_int err;
+
+    size_t const max_local_size = 256;
+    size_t const groups_per_compute_unit = 8;
+    cl_uint const iterations = 4096;
+    cl_float const never_flag = -1.0f;
+
+    // Odd strides are conflict free, powers of two conflict the most
+    int const num_strides = 8;
+    cl_uint const strides[] = {1, 2, 3, 4, 8, 16, 17, 32};
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "local_memory.cl",
+                NULL,
+                program
+                ));
+
+    cl::Kernel kernel;
+    cle_sanitize_ref_return(
+            kernel = cl::Kernel(program, "local_read", &err),
+            err
+            );
+
+    size_t local_size = std::min(
+            max_local_size,
+            kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+    size_t global_size = local_size
+        * groups_per_compute_unit
+        * device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+    cl_ulong local_mem_bytes = device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+
+    cle::TypedBuffer<cl_float> d_out(
+            context_,
+            CL_MEM_WRITE_ONLY,
+            global_size,
+            NULL
+            );
+
+    kernel.setArg(0, d_out);
+    kernel.setArg(3, iterations);
+    kernel.setArg(4, never_flag);
+
+    profiler_->add_table(
+            "local memory",
+            {"stride", "local size", "global size", "bytes",
+            "median (us)", "GB/s"});
+
+    for (int s = 0; s < num_strides; ++s) {
+        size_t scratch_bytes = local_size * strides[s] * sizeof(cl_float);
+        if (scratch_bytes > local_mem_bytes) {
+            break;
+        }
+
+        kernel.setArg(1, cl::Local(scratch_bytes));
+        kernel.setArg(2, strides[s]);
+
+        size_t bytes = global_size * iterations * sizeof(cl_float);
+        GpuBench::Statistics time;
+        cle_sanitize_val_return(
+                GpuBench::time_kernel(
+                    commandqueue_,
+                    kernel,
+                    cl::NDRange(global_size),
+                    cl::NDRange(local_size),
+                    repetitions,
+                    *profiler_,
+                    "local read stride " + std::to_string(strides[s]),
+                    bytes,
+                    time));
+
+        profiler_->add_row({
+                strides[s],
+                local_size,
+                global_size,
+                bytes,
+                time.median / 1000.0,
+                time.median ? (double) bytes / time.median : 0
+                });
+    }
+
+    return 1;
+}
@@ -11,8 +11,6 @@
 #include "common.hpp"
 
 #include <vector>
-#include <sstream>
-#include <iostream>
 
 #include <clext.hpp>
 
@@ -30,19 +28,28 @@ void gpubench::PciBandwidth::set_cl_commandqueue(cl::CommandQueue queue) {
     commandqueue_ = queue;
 }
 
-int gpubench::PciBandwidth::run(size_t buffer_bytes) {
+void gpubench::PciBandwidth::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::PciBandwidth::run(size_t buffer_bytes, unsigned int repetitions) {
 
     cl_int err;
 
+    size_t const min_transfer_bytes = 4 * 1024;
+
     size_t buffer_size = buffer_bytes / sizeof(cl_int);
 
-    cl::Event map_event;
-    cl::Event unmap_event;
-    cl::Event regular_write_event;
-    cl::Event regular_read_event;
-    cl::Event pinned_write_event;
-    cl::Event pinned_read_event;
-    cl::Event pinned_copy_read_event;
+    int const num_events = 7;
+    char const* names[] = {
+        "regular read buffer",
+        "regular write buffer",
+        "pinned map",
+        "pinned unmap",
+        "pinned read buffer",
+        "pinned write buffer",
+        "pinned copy read"
+    };
 
     std::vector<cl_int> h_regular_buffer(buffer_size);
     cl_int *h_pinned_buffer_ptr = NULL;
@@ -68,123 +75,138 @@ int gpubench::PciBandwidth::run(size_t buffer_bytes) {
             NULL
             );
 
-    // Regular read / write tests
-    cle_sanitize_val_return(
-            commandqueue_.enqueueWriteBuffer(
-                d_regular_buffer,
-                CL_FALSE,
-                0,
-                d_regular_buffer.bytes(),
-                h_regular_buffer.data(),
-                NULL,
-                &regular_write_event));
-
-    cle_sanitize_val_return(
-            commandqueue_.enqueueReadBuffer(
-                d_regular_buffer,
-                CL_FALSE,
-                0,
-                d_regular_buffer.bytes(),
-                h_regular_buffer.data(),
-                NULL,
-                &regular_read_event));
-
-    // Pin memory
-    cle_sanitize_ref_return(
-            h_pinned_buffer_ptr = (cl_int *) commandqueue_.enqueueMapBuffer(
-                h_pinned_buffer,
-                CL_TRUE,
-                CL_MAP_WRITE_INVALIDATE_REGION,
-                0,
-                h_pinned_buffer.bytes(),
-                0,
+    // Transfer sizes double from 4 KiB and end with the full buffer
+    std::vector<size_t> transfer_sizes;
+    for (size_t bytes = min_transfer_bytes; bytes < buffer_bytes; bytes *= 2) {
+        transfer_sizes.push_back(bytes);
+    }
+    transfer_sizes.push_back(buffer_bytes);
+
+    profiler_->add_table(
+            "pci bandwidth",
+            {"transfer", "bytes", "min (us)", "median (us)", "p99 (us)", "GB/s"});
+
+    for (size_t transfer_bytes : transfer_sizes) {
+
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            cl::Event map_event;
+            cl::Event unmap_event;
+            cl::Event regular_write_event;
+            cl::Event regular_read_event;
+            cl::Event pinned_write_event;
+            cl::Event pinned_read_event;
+            cl::Event pinned_copy_read_event;
+
+            // Regular read / write tests
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueWriteBuffer(
+                        d_regular_buffer,
+                        CL_FALSE,
+                        0,
+                        transfer_bytes,
+                        h_regular_buffer.data(),
+                        NULL,
+                        &regular_write_event));
+
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueReadBuffer(
+                        d_regular_buffer,
+                        CL_FALSE,
+                        0,
+                        transfer_bytes,
+                        h_regular_buffer.data(),
+                        NULL,
+                        &regular_read_event));
+
+            // Pin memory
+            cle_sanitize_ref_return(
+                    h_pinned_buffer_ptr = (cl_int *) commandqueue_.enqueueMapBuffer(
+                        h_pinned_buffer,
+                        CL_TRUE,
+                        CL_MAP_WRITE_INVALIDATE_REGION,
+                        0,
+                        transfer_bytes,
+                        0,
+                        &map_event,
+                        &err),
+                    err
+                    );
+
+            // Pinned memory write test
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueWriteBuffer(
+                        d_pinned_buffer,
+                        CL_FALSE,
+                        0,
+                        transfer_bytes,
+                        h_pinned_buffer_ptr,
+                        NULL,
+                        &pinned_write_event));
+
+
+            // Pinned memory read test
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueReadBuffer(
+                        d_pinned_buffer,
+                        CL_FALSE,
+                        0,
+                        transfer_bytes,
+                        h_pinned_buffer_ptr,
+                        NULL,
+                        &pinned_read_event));
+
+            // Unpin memory
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueUnmapMemObject(
+                        h_pinned_buffer,
+                        h_pinned_buffer_ptr,
+                        NULL,
+                        &unmap_event
+                        ));
+
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueCopyBuffer(
+                        d_pinned_buffer,
+                        h_pinned_buffer,
+                        0,
+                        0,
+                        transfer_bytes,
+                        NULL,
+                        &pinned_copy_read_event
+                        ));
+
+            cl::Event const* events[] = {
+                &regular_read_event,
+                &regular_write_event,
                 &map_event,
-                &err),
-            err
-            );
-
-    // Pinned memory write test
-    cle_sanitize_val_return(
-            commandqueue_.enqueueWriteBuffer(
-                d_pinned_buffer,
-                CL_FALSE,
-                0,
-                d_pinned_buffer.bytes(),
-                h_pinned_buffer_ptr,
-                NULL,
-                &pinned_write_event));
-
-
-    // Pinned memory read test
-    cle_sanitize_val_return(
-            commandqueue_.enqueueReadBuffer(
-                d_pinned_buffer,
-                CL_FALSE,
-                0,
-                d_pinned_buffer.bytes(),
-                h_pinned_buffer_ptr,
-                NULL,
-                &pinned_read_event));
-
-    // Unpin memory
-    cle_sanitize_val_return(
-            commandqueue_.enqueueUnmapMemObject(
-                h_pinned_buffer,
-                h_pinned_buffer_ptr,
-                NULL,
-                &unmap_event
-                ));
-
-    cle_sanitize_val_return(
-            commandqueue_.enqueueCopyBuffer(
-                d_pinned_buffer,
-                h_pinned_buffer,
-                0,
-                0,
-                h_pinned_buffer.bytes(),
-                NULL,
+                &unmap_event,
+                &pinned_read_event,
+                &pinned_write_event,
                 &pinned_copy_read_event
-                ));
+            };
 
-    int num_events = 7;
-    char const* names[] = {
-        "regular read buffer",
-        "regular write buffer",
-        "pinned map",
-        "pinned unmap",
-        "pinned read buffer",
-        "pinned write buffer",
-        "pinned copy read"
-    };
+            for (int i = 0; i < num_events; ++i) {
+                profiler_->add_event(names[i], *events[i], transfer_bytes);
+            }
 
-    cl::Event const* events[] = {
-        &regular_read_event,
-        &regular_write_event,
-        &map_event,
-        &unmap_event,
-        &pinned_read_event,
-        &pinned_write_event,
-        &pinned_copy_read_event
-    };
-
-    std::stringstream ss;
-    for (int i = 0; i < num_events; ++i) {
-        ss << names[i];
-        ss << ((i == num_events - 1) ? '\n' : ',');
-    }
-
-    for (int i = 0; i < num_events; ++i) {
-        uint64_t duration;
-        GpuBench::event_nanoseconds(*events[i], duration);
-
-        ss << duration / 1000;
+            cle_sanitize_val_return(
+                    profiler_->collect(commandqueue_));
+        }
 
-        if (i != num_events - 1) {
-            ss << ',';
+        for (int i = 0; i < num_events; ++i) {
+            GpuBench::Statistics stats = GpuBench::statistics(
+                    profiler_->execution_times(names[i], transfer_bytes));
+
+            profiler_->add_row({
+                    names[i],
+                    transfer_bytes,
+                    stats.min / 1000.0,
+                    stats.median / 1000.0,
+                    stats.p99 / 1000.0,
+                    stats.median ? (double) transfer_bytes / stats.median : 0
+                    });
         }
     }
 
-    std::cout << ss.str() << std::endl;
-
     return 1;
 }
@@ -10,6 +10,8 @@
 #ifndef PCI_BANDWIDTH_HPP
 #define PCI_BANDWIDTH_HPP
 
+#include "profiler.hpp"
+
 #ifdef MAC
 #include <OpenCL/cl.hpp>
 #else
@@ -21,12 +23,14 @@ namespace gpubench {
     public:
         void set_cl_context(cl::Context context);
         void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
 
-        int run(size_t buffer_bytes);
+        int run(size_t buffer_bytes, unsigned int repetitions);
 
     private:
         cl::Context context_;
         cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
     };
 }
 
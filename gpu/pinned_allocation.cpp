@@ -0,0 +1,327 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "pinned_allocation.hpp"
+#include "common.hpp"
+#include "pinned_pool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    uint64_t elapsed_nanoseconds(std::chrono::steady_clock::time_point& begin) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        uint64_t elapsed =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin).count();
+        begin = now;
+
+        return elapsed;
+    }
+}
+
+void gpubench::PinnedAllocation::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::PinnedAllocation::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::PinnedAllocation::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+/*
+ * Host time of each step in the life of a pinned buffer
+ */
+int gpubench::PinnedAllocation::allocation_cost(
+        size_t buffer_bytes,
+        unsigned int repetitions) {
+
+    cl_int err;
+
+    int const num_steps = 5;
+
+    profiler_->add_table(
+            "pinned allocation",
+            {"bytes", "create (us)", "map (us)", "first touch (us)",
+            "unmap (us)", "release (us)", "total (us)"});
+
+    std::vector<size_t> sizes;
+    for (size_t bytes = PinnedPool::min_class_bytes; bytes < buffer_bytes; bytes *= 2) {
+        sizes.push_back(bytes);
+    }
+    sizes.push_back(buffer_bytes);
+
+    for (size_t bytes : sizes) {
+        std::vector<std::vector<uint64_t>> times(num_steps + 1);
+
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            uint64_t step_times[num_steps];
+            std::chrono::steady_clock::time_point begin =
+                std::chrono::steady_clock::now();
+
+            cl::Buffer buffer;
+            cle_sanitize_ref_return(
+                    buffer = cl::Buffer(
+                        context_,
+                        CL_MEM_ALLOC_HOST_PTR | CL_MEM_READ_WRITE,
+                        bytes,
+                        NULL,
+                        &err),
+                    err
+                    );
+            step_times[0] = elapsed_nanoseconds(begin);
+
+            void *ptr;
+            cle_sanitize_ref_return(
+                    ptr = commandqueue_.enqueueMapBuffer(
+                        buffer,
+                        CL_TRUE,
+                        CL_MAP_WRITE_INVALIDATE_REGION,
+                        0,
+                        bytes,
+                        NULL,
+                        NULL,
+                        &err),
+                    err
+                    );
+            step_times[1] = elapsed_nanoseconds(begin);
+
+            // Some runtimes only back the mapping on first access
+            std::memset(ptr, 0, bytes);
+            step_times[2] = elapsed_nanoseconds(begin);
+
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueUnmapMemObject(
+                        buffer,
+                        ptr,
+                        NULL,
+                        NULL));
+            cle_sanitize_val_return(
+                    commandqueue_.finish());
+            step_times[3] = elapsed_nanoseconds(begin);
+
+            buffer = cl::Buffer();
+            step_times[4] = elapsed_nanoseconds(begin);
+
+            uint64_t total = 0;
+            for (int s = 0; s < num_steps; ++s) {
+                times[s].push_back(step_times[s]);
+                total += step_times[s];
+            }
+            times[num_steps].push_back(total);
+        }
+
+        std::vector<Profiler::Cell> row(1, bytes);
+        for (std::vector<uint64_t> const& step : times) {
+            row.push_back(GpuBench::statistics(step).median / 1000.0);
+        }
+        profiler_->add_row(row);
+    }
+
+    return 1;
+}
+
+/*
+ * Fill a host buffer and write it to the device, for a sequence of
+ * mixed transfer sizes. The host buffer is either pageable memory, a
+ * pinned buffer allocated per transfer, or a pinned buffer from a pool.
+ */
+int gpubench::PinnedAllocation::mixed_transfers(
+        size_t buffer_bytes,
+        unsigned int repetitions) {
+
+    cl_int err;
+
+    size_t const num_transfers = 64;
+
+    enum Strategy {Pageable, PinnedPerTransfer, Pooled};
+    int const num_strategies = 3;
+    char const* names[] = {"pageable", "pinned per transfer", "pinned pool"};
+
+    // Sizes are log-uniform over the size classes up to the buffer size
+    unsigned int num_classes = 0;
+    while ((PinnedPool::min_class_bytes << (num_classes + 1)) <= buffer_bytes) {
+        ++num_classes;
+    }
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned int> class_distribution(0, num_classes);
+    std::vector<size_t> sizes;
+    size_t total_bytes = 0;
+    for (size_t t = 0; t < num_transfers; ++t) {
+        size_t class_bytes = PinnedPool::min_class_bytes << class_distribution(generator);
+        std::uniform_int_distribution<size_t> size_distribution(
+                class_bytes / 2 / 64 + 1,
+                class_bytes / 64);
+        sizes.push_back(size_distribution(generator) * 64);
+        total_bytes += sizes.back();
+    }
+
+    cl::Buffer d_buffer;
+    cle_sanitize_ref_return(
+            d_buffer = cl::Buffer(
+                context_,
+                CL_MEM_READ_WRITE,
+                buffer_bytes,
+                NULL,
+                &err),
+            err
+            );
+
+    std::vector<char> h_pageable(buffer_bytes);
+
+    PinnedPool pool;
+    pool.set_cl_context(context_);
+    pool.set_cl_commandqueue(commandqueue_);
+
+    profiler_->add_table(
+            "pinned pool",
+            {"strategy", "transfers", "bytes", "median total (ms)",
+            "per transfer (us)", "GB/s", "pool hits", "pool misses",
+            "speedup over pinned per transfer"});
+
+    std::vector<GpuBench::Statistics> totals(num_strategies);
+
+    for (int s = 0; s < num_strategies; ++s) {
+        std::vector<uint64_t> times;
+
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            std::chrono::steady_clock::time_point begin =
+                std::chrono::steady_clock::now();
+
+            for (size_t bytes : sizes) {
+                PinnedPool::Allocation allocation;
+                void *ptr = h_pageable.data();
+
+                if (s == PinnedPerTransfer) {
+                    cle_sanitize_ref_return(
+                            allocation.buffer = cl::Buffer(
+                                context_,
+                                CL_MEM_ALLOC_HOST_PTR | CL_MEM_READ_WRITE,
+                                bytes,
+                                NULL,
+                                &err),
+                            err
+                            );
+
+                    cle_sanitize_ref_return(
+                            ptr = commandqueue_.enqueueMapBuffer(
+                                allocation.buffer,
+                                CL_TRUE,
+                                CL_MAP_WRITE_INVALIDATE_REGION,
+                                0,
+                                bytes,
+                                NULL,
+                                NULL,
+                                &err),
+                            err
+                            );
+                }
+                else if (s == Pooled) {
+                    cle_sanitize_val_return(
+                            pool.acquire(bytes, allocation));
+                    ptr = allocation.ptr;
+                }
+
+                std::memset(ptr, (int) bytes, bytes);
+
+                cle_sanitize_val_return(
+                        commandqueue_.enqueueWriteBuffer(
+                            d_buffer,
+                            CL_TRUE,
+                            0,
+                            bytes,
+                            ptr,
+                            NULL,
+                            NULL));
+
+                if (s == PinnedPerTransfer) {
+                    cle_sanitize_val_return(
+                            commandqueue_.enqueueUnmapMemObject(
+                                allocation.buffer,
+                                ptr,
+                                NULL,
+                                NULL));
+                    cle_sanitize_val_return(
+                            commandqueue_.finish());
+                }
+                else if (s == Pooled) {
+                    pool.release(allocation);
+                }
+            }
+
+            std::chrono::steady_clock::time_point end =
+                std::chrono::steady_clock::now();
+            times.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        end - begin).count());
+        }
+
+        totals[s] = GpuBench::statistics(times);
+    }
+
+    PinnedPool::Statistics pool_stats = pool.statistics();
+
+    for (int s = 0; s < num_strategies; ++s) {
+        uint64_t median = totals[s].median;
+
+        profiler_->add_row({
+                names[s],
+                num_transfers,
+                total_bytes,
+                median / 1000000.0,
+                median / 1000.0 / num_transfers,
+                median ? (double) total_bytes / median : 0,
+                (s == Pooled) ? pool_stats.hits : 0,
+                (s == Pooled) ? pool_stats.misses : 0,
+                median ? (double) totals[PinnedPerTransfer].median / median : 0
+                });
+    }
+
+    cle_sanitize_val_return(
+            pool.clear());
+
+    return 1;
+}
+
+int gpubench::PinnedAllocation::run(size_t buffer_bytes, unsigned int repetitions) {
+
+    int ret;
+
+    if (buffer_bytes < PinnedPool::min_class_bytes) {
+        std::cerr << "Buffer smaller than the smallest pinned size class" << std::endl;
+        return CL_INVALID_VALUE;
+    }
+
+    ret = allocation_cost(buffer_bytes, repetitions);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = mixed_transfers(buffer_bytes, repetitions);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return 1;
+}
@@ -0,0 +1,46 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef PINNED_ALLOCATION_HPP
+#define PINNED_ALLOCATION_HPP
+
+#include "profiler.hpp"
+
+#include <cstddef>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Cost of creating, mapping, unmapping and releasing pinned buffers,
+     * and what a PinnedPool saves on transfers of mixed sizes
+     */
+    class PinnedAllocation {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        int run(size_t buffer_bytes, unsigned int repetitions);
+
+    private:
+        int allocation_cost(size_t buffer_bytes, unsigned int repetitions);
+        int mixed_transfers(size_t buffer_bytes, unsigned int repetitions);
+
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+    };
+}
+
+#endif /* PINNED_ALLOCATION_HPP */
@@ -0,0 +1,129 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "pinned_pool.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+gpubench::PinnedPool::PinnedPool() {
+    statistics_ = {0, 0, 0};
+}
+
+gpubench::PinnedPool::~PinnedPool() {
+    clear();
+}
+
+void gpubench::PinnedPool::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::PinnedPool::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+/*
+ * Size class c holds buffers of min_class_bytes << c bytes
+ */
+unsigned int gpubench::PinnedPool::size_class(size_t bytes) {
+    unsigned int c = 0;
+    while ((min_class_bytes << c) < bytes) {
+        ++c;
+    }
+
+    return c;
+}
+
+cl_int gpubench::PinnedPool::acquire(size_t bytes, Allocation& allocation) {
+
+    cl_int err;
+
+    unsigned int c = size_class(bytes);
+    if (c >= free_lists_.size()) {
+        free_lists_.resize(c + 1);
+    }
+
+    if (!free_lists_[c].empty()) {
+        allocation = free_lists_[c].back();
+        free_lists_[c].pop_back();
+        ++statistics_.hits;
+
+        return CL_SUCCESS;
+    }
+
+    allocation.bytes = min_class_bytes << c;
+
+    cle_sanitize_ref_return(
+            allocation.buffer = cl::Buffer(
+                context_,
+                CL_MEM_ALLOC_HOST_PTR | CL_MEM_READ_WRITE,
+                allocation.bytes,
+                NULL,
+                &err),
+            err
+            );
+
+    cle_sanitize_ref_return(
+            allocation.ptr = commandqueue_.enqueueMapBuffer(
+                allocation.buffer,
+                CL_TRUE,
+                CL_MAP_READ | CL_MAP_WRITE,
+                0,
+                allocation.bytes,
+                NULL,
+                NULL,
+                &err),
+            err
+            );
+
+    ++statistics_.misses;
+    statistics_.pinned_bytes += allocation.bytes;
+
+    return CL_SUCCESS;
+}
+
+void gpubench::PinnedPool::release(Allocation const& allocation) {
+    free_lists_[size_class(allocation.bytes)].push_back(allocation);
+}
+
+cl_int gpubench::PinnedPool::clear() {
+
+    for (std::vector<Allocation>& free_list : free_lists_) {
+        for (Allocation& allocation : free_list) {
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueUnmapMemObject(
+                        allocation.buffer,
+                        allocation.ptr,
+                        NULL,
+                        NULL));
+            statistics_.pinned_bytes -= allocation.bytes;
+        }
+    }
+
+    if (!free_lists_.empty()) {
+        cle_sanitize_val_return(
+                commandqueue_.finish());
+    }
+
+    free_lists_.clear();
+
+    return CL_SUCCESS;
+}
+
+gpubench::PinnedPool::Statistics gpubench::PinnedPool::statistics() const {
+    return statistics_;
+}
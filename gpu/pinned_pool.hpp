@@ -0,0 +1,75 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef PINNED_POOL_HPP
+#define PINNED_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Pool of pinned, persistently mapped host buffers
+     *
+     * Buffers are allocated with CL_MEM_ALLOC_HOST_PTR and mapped once.
+     * Released buffers go back to a free list per power of two size
+     * class and are handed out again instead of pinning new memory.
+     * Not thread safe, use one pool per thread or context.
+     */
+    class PinnedPool {
+    public:
+        struct Allocation {
+            cl::Buffer buffer;
+            void *ptr;
+            size_t bytes;
+        };
+
+        struct Statistics {
+            unsigned int hits;
+            unsigned int misses;
+            size_t pinned_bytes;
+        };
+
+        PinnedPool();
+        ~PinnedPool();
+
+        PinnedPool(PinnedPool const&) = delete;
+        PinnedPool& operator=(PinnedPool const&) = delete;
+
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+
+        // At least bytes of pinned host memory, allocation.bytes is the capacity
+        cl_int acquire(size_t bytes, Allocation& allocation);
+        void release(Allocation const& allocation);
+
+        // Unmap and free all buffers in the free lists
+        cl_int clear();
+
+        Statistics statistics() const;
+
+        static size_t const min_class_bytes = 4096;
+
+    private:
+        static unsigned int size_class(size_t bytes);
+
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        std::vector<std::vector<Allocation>> free_lists_;
+        Statistics statistics_;
+    };
+}
+
+#endif /* PINNED_POOL_HPP */
@@ -0,0 +1,451 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "profiler.hpp"
+#include "common.hpp"
+#include "Version.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+#ifndef GIT_REVISION
+#define GIT_REVISION "unknown"
+#endif
+
+namespace {
+    std::string json_string(std::string const& str) {
+        std::stringstream ss;
+
+        ss << '"';
+        for (char c : str) {
+            switch (c) {
+                case '"':
+                    ss << "\\\"";
+                    break;
+                case '\\':
+                    ss << "\\\\";
+                    break;
+                case '\n':
+                    ss << "\\n";
+                    break;
+                case '\t':
+                    ss << "\\t";
+                    break;
+                default:
+                    if ((unsigned char) c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        ss << escaped;
+                    }
+                    else {
+                        ss << c;
+                    }
+            }
+        }
+        ss << '"';
+
+        return ss.str();
+    }
+
+    std::string csv_string(std::string const& str) {
+        if (str.find_first_of(",\"\n") == std::string::npos) {
+            return str;
+        }
+
+        std::string quoted = "\"";
+        for (char c : str) {
+            if (c == '"') {
+                quoted += '"';
+            }
+            quoted += c;
+        }
+        quoted += '"';
+
+        return quoted;
+    }
+
+    // Throughput columns such as "GB/s" or "launches/s" add up across devices
+    bool is_throughput(std::string const& column) {
+        return column.size() >= 2
+            && column.compare(column.size() - 2, 2, "/s") == 0;
+    }
+
+    std::string format_number(double number, bool json) {
+        if (json && !std::isfinite(number)) {
+            return "null";
+        }
+
+        std::stringstream ss;
+        if (number == std::floor(number) && std::fabs(number) < 1e15) {
+            ss << (long long) number;
+        }
+        else {
+            // Round-trips, CSV and JSON are read back by scripts
+            ss << std::setprecision(std::numeric_limits<double>::max_digits10)
+                << number;
+        }
+
+        return ss.str();
+    }
+}
+
+void gpubench::Profiler::set_device(cl::Device const& device) {
+    cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
+
+    add_metadata("git revision", GIT_REVISION);
+    add_metadata("platform name", platform.getInfo<CL_PLATFORM_NAME>());
+    add_metadata("platform vendor", platform.getInfo<CL_PLATFORM_VENDOR>());
+    add_metadata("platform version", platform.getInfo<CL_PLATFORM_VERSION>());
+    add_metadata("device name", device.getInfo<CL_DEVICE_NAME>());
+    add_metadata("device vendor", device.getInfo<CL_DEVICE_VENDOR>());
+    add_metadata("device version", device.getInfo<CL_DEVICE_VERSION>());
+    add_metadata("driver version", device.getInfo<CL_DRIVER_VERSION>());
+}
+
+void gpubench::Profiler::add_metadata(
+        std::string const& key,
+        std::string const& value) {
+    // Strings returned by OpenCL may carry their terminating zero
+    std::string trimmed = value.substr(0, value.find('\0'));
+
+    metadata_.push_back(std::make_pair(key, trimmed));
+}
+
+void gpubench::Profiler::add_event(
+        std::string const& name,
+        cl::Event const& event,
+        size_t bytes) {
+    Record record;
+    record.name = name;
+    record.bytes = bytes;
+    record.phases = GpuBench::EventPhases();
+
+    pending_.push_back(std::make_pair(record, event));
+}
+
+cl_int gpubench::Profiler::collect(cl::CommandQueue const& queue) {
+    return collect(std::vector<cl::CommandQueue>(1, queue));
+}
+
+cl_int gpubench::Profiler::collect(std::vector<cl::CommandQueue> const& queues) {
+
+    for (cl::CommandQueue const& queue : queues) {
+        cle_sanitize_val_return(
+                queue.finish());
+    }
+
+    for (std::pair<Record, cl::Event>& pending : pending_) {
+        Record& record = pending.first;
+        cl::Event const& event = pending.second;
+
+        cle_sanitize_val_return(
+                event.getProfilingInfo(
+                    CL_PROFILING_COMMAND_QUEUED,
+                    &record.phases.queued));
+
+        cle_sanitize_val_return(
+                event.getProfilingInfo(
+                    CL_PROFILING_COMMAND_SUBMIT,
+                    &record.phases.submit));
+
+        cle_sanitize_val_return(
+                event.getProfilingInfo(
+                    CL_PROFILING_COMMAND_START,
+                    &record.phases.start));
+
+        cle_sanitize_val_return(
+                event.getProfilingInfo(
+                    CL_PROFILING_COMMAND_END,
+                    &record.phases.end));
+
+        records_.push_back(record);
+    }
+
+    pending_.clear();
+
+    return CL_SUCCESS;
+}
+
+std::vector<uint64_t> gpubench::Profiler::execution_times(
+        std::string const& name,
+        size_t bytes) const {
+    std::vector<uint64_t> times;
+
+    for (Record const& record : records_) {
+        if (record.name == name && (bytes == 0 || record.bytes == bytes)) {
+            times.push_back(record.execution_time());
+        }
+    }
+
+    return times;
+}
+
+std::vector<gpubench::Profiler::Record> const& gpubench::Profiler::records() const {
+    return records_;
+}
+
+std::vector<gpubench::Profiler::Record> gpubench::Profiler::last_records(
+        size_t count) const {
+    if (count > records_.size()) {
+        count = records_.size();
+    }
+
+    return std::vector<Record>(records_.end() - count, records_.end());
+}
+
+void gpubench::Profiler::add_table(
+        std::string const& name,
+        std::vector<std::string> const& columns) {
+    Table table;
+    table.name = name;
+    table.columns = columns;
+
+    tables_.push_back(table);
+}
+
+void gpubench::Profiler::add_row(std::vector<Cell> const& cells) {
+    if (tables_.empty()) {
+        return;
+    }
+
+    tables_.back().rows.push_back(cells);
+}
+
+void gpubench::Profiler::append(Profiler const& other, std::string const& prefix) {
+    for (std::pair<std::string, std::string> const& meta : other.metadata_) {
+        metadata_.push_back(std::make_pair(prefix + meta.first, meta.second));
+    }
+
+    for (Table const& table : other.tables_) {
+        tables_.push_back(table);
+        tables_.back().name = prefix + table.name;
+    }
+
+    for (Record const& record : other.records_) {
+        records_.push_back(record);
+        records_.back().name = prefix + record.name;
+    }
+}
+
+/*
+ * Build an aggregate of every table that has the same name, columns and
+ * number of rows in all runs. Throughput columns are summed, columns
+ * that hold the same value in all runs (the parameters of a row) are
+ * kept and all other columns are dropped.
+ */
+void gpubench::Profiler::add_aggregate(std::vector<Profiler> const& runs) {
+    if (runs.empty()) {
+        return;
+    }
+
+    for (Table const& first : runs[0].tables_) {
+        std::vector<Table const*> tables;
+        for (Profiler const& run : runs) {
+            for (Table const& table : run.tables_) {
+                if (table.name == first.name
+                        && table.columns == first.columns
+                        && table.rows.size() == first.rows.size()) {
+                    tables.push_back(&table);
+                    break;
+                }
+            }
+        }
+
+        if (tables.size() != runs.size()) {
+            continue;
+        }
+
+        std::vector<size_t> keep;
+        for (size_t c = 0; c < first.columns.size(); ++c) {
+            bool shared = true;
+            for (size_t r = 0; r < first.rows.size() && shared; ++r) {
+                if (c >= first.rows[r].size()) {
+                    shared = false;
+                    break;
+                }
+                for (Table const* table : tables) {
+                    Cell const& a = first.rows[r][c];
+                    Cell const& b = table->rows[r].size() > c
+                        ? table->rows[r][c]
+                        : Cell("");
+                    if (a.numeric != b.numeric
+                            || a.number != b.number
+                            || a.text != b.text) {
+                        shared = false;
+                        break;
+                    }
+                }
+            }
+
+            if (shared || is_throughput(first.columns[c])) {
+                keep.push_back(c);
+            }
+        }
+
+        Table aggregate;
+        aggregate.name = "aggregate " + first.name;
+        for (size_t c : keep) {
+            aggregate.columns.push_back(first.columns[c]);
+        }
+
+        for (size_t r = 0; r < first.rows.size(); ++r) {
+            std::vector<Cell> row;
+            for (size_t c : keep) {
+                if (!is_throughput(first.columns[c])) {
+                    row.push_back(first.rows[r][c]);
+                    continue;
+                }
+
+                double sum = 0;
+                for (Table const* table : tables) {
+                    if (table->rows[r].size() > c && table->rows[r][c].numeric) {
+                        sum += table->rows[r][c].number;
+                    }
+                }
+                row.push_back(sum);
+            }
+            aggregate.rows.push_back(row);
+        }
+
+        tables_.push_back(aggregate);
+    }
+}
+
+void gpubench::Profiler::print(std::ostream& os, Format format, bool events) const {
+    switch (format) {
+        case Format::Csv:
+            print_csv(os, events);
+            break;
+        case Format::Json:
+            print_json(os, events);
+            break;
+    }
+}
+
+void gpubench::Profiler::print_csv(std::ostream& os, bool events) const {
+    std::stringstream ss;
+
+    for (std::pair<std::string, std::string> const& meta : metadata_) {
+        ss << "# " << meta.first << ": " << meta.second << '\n';
+    }
+
+    for (Table const& table : tables_) {
+        ss << "\n# " << table.name << '\n';
+
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            ss << csv_string(table.columns[c]);
+            ss << ((c == table.columns.size() - 1) ? '\n' : ',');
+        }
+
+        for (std::vector<Cell> const& row : table.rows) {
+            for (size_t c = 0; c < row.size(); ++c) {
+                ss << (row[c].numeric
+                        ? format_number(row[c].number, false)
+                        : csv_string(row[c].text));
+                ss << ((c == row.size() - 1) ? '\n' : ',');
+            }
+        }
+    }
+
+    if (events) {
+        ss << "\n# events\n"
+            << "name,bytes,queued,submit,start,end,"
+            "queue latency (ns),execution (ns)\n";
+
+        for (Record const& record : records_) {
+            ss << csv_string(record.name) << ','
+                << record.bytes << ','
+                << record.phases.queued << ','
+                << record.phases.submit << ','
+                << record.phases.start << ','
+                << record.phases.end << ','
+                << record.queue_latency() << ','
+                << record.execution_time()
+                << '\n';
+        }
+    }
+
+    os << ss.str() << std::endl;
+}
+
+void gpubench::Profiler::print_json(std::ostream& os, bool events) const {
+    std::stringstream ss;
+
+    ss << "{\n  \"metadata\": {";
+    for (size_t m = 0; m < metadata_.size(); ++m) {
+        ss << (m ? ",\n    " : "\n    ")
+            << json_string(metadata_[m].first) << ": "
+            << json_string(metadata_[m].second);
+    }
+    ss << "\n  },\n  \"tables\": [";
+
+    for (size_t t = 0; t < tables_.size(); ++t) {
+        Table const& table = tables_[t];
+
+        ss << (t ? ",\n    {" : "\n    {")
+            << "\n      \"name\": " << json_string(table.name) << ','
+            << "\n      \"rows\": [";
+
+        for (size_t r = 0; r < table.rows.size(); ++r) {
+            std::vector<Cell> const& row = table.rows[r];
+
+            ss << (r ? ",\n        {" : "\n        {");
+            for (size_t c = 0; c < row.size() && c < table.columns.size(); ++c) {
+                ss << (c ? ", " : "")
+                    << json_string(table.columns[c]) << ": "
+                    << (row[c].numeric
+                            ? format_number(row[c].number, true)
+                            : json_string(row[c].text));
+            }
+            ss << '}';
+        }
+
+        ss << "\n      ]\n    }";
+    }
+    ss << "\n  ]";
+
+    if (events) {
+        ss << ",\n  \"events\": [";
+
+        for (size_t e = 0; e < records_.size(); ++e) {
+            Record const& record = records_[e];
+
+            ss << (e ? ",\n    {" : "\n    {")
+                << "\"name\": " << json_string(record.name)
+                << ", \"bytes\": " << record.bytes
+                << ", \"queued\": " << record.phases.queued
+                << ", \"submit\": " << record.phases.submit
+                << ", \"start\": " << record.phases.start
+                << ", \"end\": " << record.phases.end
+                << ", \"queue latency (ns)\": " << record.queue_latency()
+                << ", \"execution (ns)\": " << record.execution_time()
+                << '}';
+        }
+
+        ss << "\n  ]";
+    }
+
+    ss << "\n}";
+
+    os << ss.str() << std::endl;
+}
@@ -0,0 +1,117 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Collects named events and result tables of a benchmark run
+     *
+     * Events are registered without waiting on them. collect() finishes
+     * the queues once and then reads all four profiling timestamps of
+     * every pending event. print() writes the metadata, the result tables
+     * and optionally the raw events as CSV or JSON.
+     */
+    class Profiler {
+    public:
+        enum class Format {Csv, Json};
+
+        struct Record {
+            std::string name;
+            size_t bytes;
+            GpuBench::EventPhases phases;
+
+            uint64_t queue_latency() const {
+                return phases.start - phases.queued;
+            }
+
+            uint64_t execution_time() const {
+                return phases.end - phases.start;
+            }
+        };
+
+        // Table cell, either a number or a string
+        struct Cell {
+            template <typename T, typename = typename std::enable_if<
+                std::is_arithmetic<T>::value>::type>
+            Cell(T value) : numeric(true), number((double) value) {}
+            Cell(char const* value) : numeric(false), number(0), text(value) {}
+            Cell(std::string const& value) : numeric(false), number(0), text(value) {}
+
+            bool numeric;
+            double number;
+            std::string text;
+        };
+
+        void set_device(cl::Device const& device);
+        void add_metadata(std::string const& key, std::string const& value);
+
+        void add_event(
+                std::string const& name,
+                cl::Event const& event,
+                size_t bytes = 0);
+
+        cl_int collect(cl::CommandQueue const& queue);
+        cl_int collect(std::vector<cl::CommandQueue> const& queues);
+
+        // Execution times of collected events with name (and bytes if not 0)
+        std::vector<uint64_t> execution_times(
+                std::string const& name,
+                size_t bytes = 0) const;
+
+        std::vector<Record> const& records() const;
+        std::vector<Record> last_records(size_t count) const;
+
+        void add_table(
+                std::string const& name,
+                std::vector<std::string> const& columns);
+        void add_row(std::vector<Cell> const& cells);
+
+        // Append metadata, tables and events of another run, names prefixed
+        void append(Profiler const& other, std::string const& prefix);
+
+        // Sum throughput columns of the tables that all runs share
+        void add_aggregate(std::vector<Profiler> const& runs);
+
+        void print(std::ostream& os, Format format, bool events) const;
+
+    private:
+        struct Table {
+            std::string name;
+            std::vector<std::string> columns;
+            std::vector<std::vector<Cell>> rows;
+        };
+
+        void print_csv(std::ostream& os, bool events) const;
+        void print_json(std::ostream& os, bool events) const;
+
+        std::vector<std::pair<std::string, std::string>> metadata_;
+        std::vector<std::pair<Record, cl::Event>> pending_;
+        std::vector<Record> records_;
+        std::vector<Table> tables_;
+    };
+}
+
+#endif /* PROFILER_HPP */
@@ -0,0 +1,289 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "program_cache.hpp"
+#include "common.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    // 64-bit FNV-1a, each field is terminated by a zero byte
+    class Fnv1a {
+    public:
+        Fnv1a() : hash_(14695981039346656037ULL) {}
+
+        void add(std::string const& field) {
+            for (unsigned char c : field) {
+                hash_ = (hash_ ^ c) * 1099511628211ULL;
+            }
+            hash_ = (hash_ ^ 0) * 1099511628211ULL;
+        }
+
+        uint64_t hash() const {
+            return hash_;
+        }
+
+    private:
+        uint64_t hash_;
+    };
+
+    std::string trim(std::string const& str) {
+        return str.substr(0, str.find('\0'));
+    }
+
+    // mkdir -p
+    bool make_directories(std::string const& path) {
+        for (size_t pos = 1; pos <= path.size(); ++pos) {
+            if (pos == path.size() || path[pos] == '/') {
+                std::string prefix = path.substr(0, pos);
+                if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+gpubench::ProgramCache::ProgramCache() {
+    statistics_ = {0, 0, 0, 0};
+}
+
+void gpubench::ProgramCache::set_directory(std::string const& directory) {
+    directory_ = directory;
+}
+
+std::string const& gpubench::ProgramCache::directory() const {
+    return directory_;
+}
+
+std::string gpubench::ProgramCache::default_directory() {
+    char const* xdg_cache = std::getenv("XDG_CACHE_HOME");
+    if (xdg_cache && *xdg_cache) {
+        return std::string(xdg_cache) + "/gpubench";
+    }
+
+    char const* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::string(home) + "/.cache/gpubench";
+    }
+
+    return "";
+}
+
+cl_int gpubench::ProgramCache::build(
+        cl::Context const& context,
+        cl::Device const& device,
+        char const* file_name,
+        std::string const& source,
+        char const* build_options,
+        cl::Program& program) {
+
+    cl_int err;
+
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+
+    std::string path;
+    bool hit = false;
+    bool rejected = false;
+
+    if (!directory_.empty()) {
+        path = entry_path(device, source, build_options);
+
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (file.good()) {
+            file.close();
+
+            err = load(context, device, path, build_options, program);
+            hit = (err == CL_SUCCESS);
+            rejected = !hit;
+        }
+    }
+
+    if (!hit) {
+        err = GpuBench::build_program_source(
+                context,
+                device,
+                file_name,
+                source,
+                build_options,
+                program);
+        if (err != CL_SUCCESS) {
+            return err;
+        }
+
+        // A cache that cannot be written only costs the next startup
+        if (!path.empty() && store(program, path) != CL_SUCCESS) {
+            std::cerr << "Cannot write program cache entry " << path << std::endl;
+        }
+    }
+
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics_.hits += hit ? 1 : 0;
+    statistics_.misses += hit ? 0 : 1;
+    statistics_.rejected += rejected ? 1 : 0;
+    statistics_.build_time +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    return CL_SUCCESS;
+}
+
+void gpubench::ProgramCache::evict(
+        cl::Device const& device,
+        std::string const& source,
+        char const* build_options) {
+    if (directory_.empty()) {
+        return;
+    }
+
+    std::remove(entry_path(device, source, build_options).c_str());
+}
+
+gpubench::ProgramCache::Statistics gpubench::ProgramCache::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+std::string gpubench::ProgramCache::entry_path(
+        cl::Device const& device,
+        std::string const& source,
+        char const* build_options) const {
+    cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
+
+    Fnv1a fnv;
+    fnv.add(source);
+    fnv.add(build_options ? build_options : "");
+    fnv.add(trim(platform.getInfo<CL_PLATFORM_NAME>()));
+    fnv.add(trim(platform.getInfo<CL_PLATFORM_VERSION>()));
+    fnv.add(trim(device.getInfo<CL_DEVICE_NAME>()));
+    fnv.add(trim(device.getInfo<CL_DEVICE_VERSION>()));
+    fnv.add(trim(device.getInfo<CL_DRIVER_VERSION>()));
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) fnv.hash());
+
+    return directory_ + "/" + name;
+}
+
+cl_int gpubench::ProgramCache::load(
+        cl::Context const& context,
+        cl::Device const& device,
+        std::string const& path,
+        char const* build_options,
+        cl::Program& program) const {
+
+    cl_int err;
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::vector<char> binary(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+    if (binary.empty()) {
+        return CL_INVALID_BINARY;
+    }
+
+    cl::Program::Binaries binaries(
+            1,
+            std::make_pair((void const*) binary.data(), binary.size())
+            );
+    std::vector<cl::Device> devices(1, device);
+    std::vector<cl_int> binary_status;
+
+    program = cl::Program(context, devices, binaries, &binary_status, &err);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+    if (!binary_status.empty() && binary_status[0] != CL_SUCCESS) {
+        return binary_status[0];
+    }
+
+    // Binaries still need a build, which only links on most runtimes
+    return program.build(devices, build_options);
+}
+
+cl_int gpubench::ProgramCache::store(
+        cl::Program const& program,
+        std::string const& path) const {
+
+    cl_int err;
+
+    if (!make_directories(directory_)) {
+        return CL_INVALID_VALUE;
+    }
+
+    std::vector<size_t> sizes;
+    cle_sanitize_ref_return(
+            sizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>(&err),
+            err
+            );
+    if (sizes.size() != 1 || sizes[0] == 0) {
+        return CL_INVALID_BINARY;
+    }
+
+    std::vector<unsigned char> binary(sizes[0]);
+    unsigned char *binary_ptr = binary.data();
+    cle_sanitize_val_return(
+            clGetProgramInfo(
+                program(),
+                CL_PROGRAM_BINARIES,
+                sizeof(binary_ptr),
+                &binary_ptr,
+                NULL));
+
+    // Write to a private file and rename, so that concurrent runs never
+    // read a partial entry
+    std::stringstream tmp_path;
+    tmp_path << path << ".tmp." << getpid() << "." << std::this_thread::get_id();
+
+    // Check after close, which flushes, so that a short write is never
+    // renamed into place
+    std::ofstream file(tmp_path.str().c_str(), std::ios::binary);
+    file.write((char const*) binary.data(), binary.size());
+    file.close();
+    if (!file.good()) {
+        std::remove(tmp_path.str().c_str());
+        return CL_INVALID_VALUE;
+    }
+
+    if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.str().c_str());
+        return CL_INVALID_VALUE;
+    }
+
+    return CL_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * On-disk cache of OpenCL program binaries
+     *
+     * Entries are keyed by a hash of the kernel source, the build options,
+     * the platform, the device and the driver version. A binary rejected
+     * by the runtime is rebuilt from source and replaced. Safe to share
+     * between host threads.
+     */
+    class ProgramCache {
+    public:
+        struct Statistics {
+            unsigned int hits;
+            unsigned int misses;
+            unsigned int rejected;
+            uint64_t build_time;
+        };
+
+        ProgramCache();
+
+        // An empty directory disables the cache
+        void set_directory(std::string const& directory);
+        std::string const& directory() const;
+
+        static std::string default_directory();
+
+        cl_int build(
+                cl::Context const& context,
+                cl::Device const& device,
+                char const* file_name,
+                std::string const& source,
+                char const* build_options,
+                cl::Program& program);
+
+        void evict(
+                cl::Device const& device,
+                std::string const& source,
+                char const* build_options);
+
+        Statistics statistics() const;
+
+    private:
+        std::string entry_path(
+                cl::Device const& device,
+                std::string const& source,
+                char const* build_options) const;
+
+        cl_int load(
+                cl::Context const& context,
+                cl::Device const& device,
+                std::string const& path,
+                char const* build_options,
+                cl::Program& program) const;
+
+        cl_int store(
+                cl::Program const& program,
+                std::string const& path) const;
+
+        std::string directory_;
+        mutable std::mutex mutex_;
+        Statistics statistics_;
+    };
+}
+
+#endif /* PROGRAM_CACHE_HPP */
@@ -0,0 +1,184 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "startup_time.hpp"
+#include "common.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    uint64_t elapsed_nanoseconds(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+    }
+}
+
+void gpubench::StartupTime::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::StartupTime::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::StartupTime::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+void gpubench::StartupTime::set_program_cache(ProgramCache& cache) {
+    cache_ = &cache;
+}
+
+int gpubench::StartupTime::run(unsigned int repetitions) {
+
+    int const num_programs = 9;
+    char const* file_names[] = {
+        "mem_bandwidth.cl",
+        "overlap.cl",
+        "zero_copy.cl",
+        "streaming.cl",
+        "variance.cl",
+        "empty.cl",
+        "local_memory.cl",
+        "atomics.cl",
+        "gather_scatter.cl"
+    };
+    char const* build_options[] = {
+        "-DVEC_WIDTH=4",
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL
+    };
+
+    if (cache_->directory().empty()) {
+        std::cerr << "Program cache is disabled, set a cache directory" << std::endl;
+        return -1;
+    }
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    profiler_->add_metadata("program cache directory", cache_->directory());
+    profiler_->add_table(
+            "startup time",
+            {"program", "build options", "source build (ms)",
+            "cold cache (ms)", "warm cache (ms)", "warm cache hits", "speedup"});
+
+    uint64_t total_source = 0;
+    uint64_t total_cold = 0;
+    uint64_t total_warm = 0;
+
+    for (int p = 0; p < num_programs; ++p) {
+        std::string source;
+        cle_sanitize_val_return(
+                GpuBench::read_kernel_source(file_names[p], source));
+
+        std::vector<uint64_t> source_times;
+        std::vector<uint64_t> cold_times;
+        std::vector<uint64_t> warm_times;
+        unsigned int warm_hits = 0;
+        bool failed = false;
+
+        for (unsigned int r = 0; r < repetitions && !failed; ++r) {
+            cl::Program program;
+            std::chrono::steady_clock::time_point begin;
+
+            begin = std::chrono::steady_clock::now();
+            if (GpuBench::build_program_source(
+                        context_,
+                        device,
+                        file_names[p],
+                        source,
+                        build_options[p],
+                        program) != CL_SUCCESS) {
+                failed = true;
+                break;
+            }
+            source_times.push_back(elapsed_nanoseconds(begin));
+
+            // Cold: build from source and store the binary
+            cache_->evict(device, source, build_options[p]);
+            begin = std::chrono::steady_clock::now();
+            cle_sanitize_val_return(
+                    cache_->build(
+                        context_,
+                        device,
+                        file_names[p],
+                        source,
+                        build_options[p],
+                        program));
+            cold_times.push_back(elapsed_nanoseconds(begin));
+
+            // Warm: load the binary stored by the cold build
+            unsigned int hits = cache_->statistics().hits;
+            begin = std::chrono::steady_clock::now();
+            cle_sanitize_val_return(
+                    cache_->build(
+                        context_,
+                        device,
+                        file_names[p],
+                        source,
+                        build_options[p],
+                        program));
+            warm_times.push_back(elapsed_nanoseconds(begin));
+            warm_hits += cache_->statistics().hits - hits;
+        }
+
+        // Programs the device cannot build, e.g. without cl_khr_fp64
+        if (failed) {
+            std::cerr << "Skipping " << file_names[p] << std::endl;
+            continue;
+        }
+
+        GpuBench::Statistics source_time = GpuBench::statistics(source_times);
+        GpuBench::Statistics cold_time = GpuBench::statistics(cold_times);
+        GpuBench::Statistics warm_time = GpuBench::statistics(warm_times);
+
+        total_source += source_time.median;
+        total_cold += cold_time.median;
+        total_warm += warm_time.median;
+
+        profiler_->add_row({
+                file_names[p],
+                build_options[p] ? build_options[p] : "",
+                source_time.median / 1000000.0,
+                cold_time.median / 1000000.0,
+                warm_time.median / 1000000.0,
+                warm_hits,
+                warm_time.median ? (double) source_time.median / warm_time.median : 0
+                });
+    }
+
+    profiler_->add_row({
+            "all programs",
+            "",
+            total_source / 1000000.0,
+            total_cold / 1000000.0,
+            total_warm / 1000000.0,
+            "",
+            total_warm ? (double) total_source / total_warm : 0
+            });
+
+    return 1;
+}
@@ -0,0 +1,44 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef STARTUP_TIME_HPP
+#define STARTUP_TIME_HPP
+
+#include "profiler.hpp"
+#include "program_cache.hpp"
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    /*
+     * Program build time of all kernels from source, with a cold program
+     * cache and with a warm program cache
+     */
+    class StartupTime {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+        void set_program_cache(ProgramCache& cache);
+
+        int run(unsigned int repetitions);
+
+    private:
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+        ProgramCache *cache_;
+    };
+}
+
+#endif /* STARTUP_TIME_HPP */
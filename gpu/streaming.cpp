@@ -0,0 +1,305 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "streaming.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <iostream>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+    // Returns the staging buffers acquired so far to the pool on every
+    // exit from stream, including errors
+    class StagingRelease {
+    public:
+        StagingRelease(
+                gpubench::PinnedPool& pool,
+                std::vector<gpubench::PinnedPool::Allocation> const& staging)
+            : pool_(pool), staging_(staging), acquired_(0) {}
+
+        ~StagingRelease() {
+            for (size_t s = 0; s < acquired_; ++s) {
+                pool_.release(staging_[s]);
+            }
+        }
+
+        void set_acquired(size_t acquired) {
+            acquired_ = acquired;
+        }
+
+    private:
+        gpubench::PinnedPool& pool_;
+        std::vector<gpubench::PinnedPool::Allocation> const& staging_;
+        size_t acquired_;
+    };
+}
+
+void gpubench::Streaming::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::Streaming::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::Streaming::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+/*
+ * Stream input to the device in chunks through in_flight pinned staging
+ * buffers from the pool and process each chunk as soon as it has arrived
+ *
+ * Chunk i uses slot i % in_flight. Before the host refills a staging
+ * buffer, it waits for the previous transfer out of it. The transfer into
+ * a device buffer waits for the kernel still working on that buffer.
+ */
+int gpubench::Streaming::stream(
+        std::vector<cl_float> const& input,
+        size_t chunk_bytes,
+        unsigned int in_flight,
+        uint64_t& time) {
+
+    cl_int err;
+
+    size_t const input_bytes = input.size() * sizeof(cl_float);
+    size_t const num_chunks = (input_bytes + chunk_bytes - 1) / chunk_bytes;
+
+    std::vector<PinnedPool::Allocation> h_staging(in_flight);
+    std::vector<cl_float *> h_staging_ptrs(in_flight);
+    std::vector<cl::Buffer> d_chunks(in_flight);
+    std::vector<cl::Event> write_events(in_flight);
+    std::vector<cl::Event> kernel_events(in_flight);
+    std::vector<bool> slot_used(in_flight, false);
+
+    // Staging buffers stay pinned for the next chunk size or repetition
+    StagingRelease staging_release(pool_, h_staging);
+
+    for (unsigned int s = 0; s < in_flight; ++s) {
+        cle_sanitize_val_return(
+                pool_.acquire(chunk_bytes, h_staging[s]));
+        staging_release.set_acquired(s + 1);
+        h_staging_ptrs[s] = (cl_float *) h_staging[s].ptr;
+
+        cle_sanitize_ref_return(
+                d_chunks[s] = cl::Buffer(
+                    context_,
+                    CL_MEM_READ_WRITE,
+                    chunk_bytes,
+                    NULL,
+                    &err),
+                err
+                );
+    }
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < num_chunks; ++i) {
+        unsigned int s = i % in_flight;
+        size_t offset = i * chunk_bytes;
+        size_t bytes = std::min(chunk_bytes, input_bytes - offset);
+        cl_uint n = (cl_uint) (bytes / sizeof(cl_float));
+
+        std::vector<cl::Event> write_wait;
+        if (slot_used[s]) {
+            cle_sanitize_val_return(
+                    write_events[s].wait());
+            write_wait.push_back(kernel_events[s]);
+        }
+        slot_used[s] = true;
+
+        std::memcpy(
+                h_staging_ptrs[s],
+                (char const *) input.data() + offset,
+                bytes);
+
+        cle_sanitize_val_return(
+                transfer_queue_.enqueueWriteBuffer(
+                    d_chunks[s],
+                    CL_FALSE,
+                    0,
+                    bytes,
+                    h_staging_ptrs[s],
+                    write_wait.empty() ? NULL : &write_wait,
+                    &write_events[s]));
+        profiler_->add_event("streaming H2D", write_events[s], bytes);
+
+        std::vector<cl::Event> kernel_wait(1, write_events[s]);
+
+        kernel_.setArg(0, d_chunks[s]);
+        kernel_.setArg(1, n);
+
+        cle_sanitize_val_return(
+                compute_queue_.enqueueNDRangeKernel(
+                    kernel_,
+                    cl::NullRange,
+                    cl::NDRange(std::min<size_t>(n, 1 << 16)),
+                    cl::NullRange,
+                    &kernel_wait,
+                    &kernel_events[s]));
+        profiler_->add_event("streaming scale", kernel_events[s], bytes);
+
+        cle_sanitize_val_return(
+                transfer_queue_.flush());
+        cle_sanitize_val_return(
+                compute_queue_.flush());
+    }
+
+    cle_sanitize_val_return(
+            transfer_queue_.finish());
+    cle_sanitize_val_return(
+            compute_queue_.finish());
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    time = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    cle_sanitize_val_return(
+            profiler_->collect(
+                std::vector<cl::CommandQueue>{transfer_queue_, compute_queue_}));
+
+    return 1;
+}
+
+int gpubench::Streaming::run(
+        size_t buffer_bytes,
+        size_t chunk_bytes,
+        unsigned int in_flight,
+        unsigned int repetitions) {
+
+    cl_int err;
+    int ret;
+
+    size_t const min_chunk_bytes = 64 * 1024;
+    cl_float const factor = 2.0f;
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    if (in_flight == 0) {
+        std::cerr << "Need at least one chunk in flight" << std::endl;
+        return CL_INVALID_VALUE;
+    }
+
+    cle_sanitize_ref_return(
+            transfer_queue_ = cl::CommandQueue(
+                context_,
+                device,
+                CL_QUEUE_PROFILING_ENABLE,
+                &err),
+            err
+            );
+
+    cle_sanitize_ref_return(
+            compute_queue_ = cl::CommandQueue(
+                context_,
+                device,
+                CL_QUEUE_PROFILING_ENABLE,
+                &err),
+            err
+            );
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "streaming.cl",
+                NULL,
+                program
+                ));
+
+    cle_sanitize_ref_return(
+            kernel_ = cl::Kernel(program, "scale", &err),
+            err
+            );
+    kernel_.setArg(2, factor);
+
+    pool_.set_cl_context(context_);
+    pool_.set_cl_commandqueue(commandqueue_);
+
+    std::vector<cl_float> input(buffer_bytes / sizeof(cl_float), 1.0f);
+
+    // Without an explicit chunk size, sweep from 64 KiB to the whole input
+    std::vector<size_t> chunk_sizes;
+    if (chunk_bytes != 0) {
+        chunk_sizes.push_back(chunk_bytes);
+    }
+    else {
+        for (size_t bytes = min_chunk_bytes; bytes < buffer_bytes; bytes *= 2) {
+            chunk_sizes.push_back(bytes);
+        }
+        chunk_sizes.push_back(buffer_bytes);
+    }
+
+    profiler_->add_table(
+            "streaming",
+            {"chunk bytes", "in flight", "min (us)", "median (us)",
+            "p99 (us)", "GB/s"});
+
+    size_t best_chunk_bytes = 0;
+    double best_throughput = 0;
+
+    for (size_t bytes : chunk_sizes) {
+        std::vector<uint64_t> times;
+
+        // Warm up
+        uint64_t time;
+        ret = stream(input, bytes, in_flight, time);
+        if (ret < 0) {
+            return ret;
+        }
+
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            ret = stream(input, bytes, in_flight, time);
+            if (ret < 0) {
+                return ret;
+            }
+            times.push_back(time);
+        }
+
+        // Only repetitions of one chunk size share staging buffers
+        cle_sanitize_val_return(
+                pool_.clear());
+
+        GpuBench::Statistics stats = GpuBench::statistics(times);
+        double throughput = stats.median
+            ? (double) buffer_bytes / stats.median
+            : 0;
+
+        if (throughput > best_throughput) {
+            best_throughput = throughput;
+            best_chunk_bytes = bytes;
+        }
+
+        profiler_->add_row({
+                bytes,
+                in_flight,
+                stats.min / 1000.0,
+                stats.median / 1000.0,
+                stats.p99 / 1000.0,
+                throughput
+                });
+    }
+
+    profiler_->add_table("streaming best", {"chunk bytes", "GB/s"});
+    profiler_->add_row({best_chunk_bytes, best_throughput});
+
+    return 1;
+}
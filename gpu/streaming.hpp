@@ -0,0 +1,55 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef STREAMING_HPP
+#define STREAMING_HPP
+
+#include "pinned_pool.hpp"
+#include "profiler.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    class Streaming {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        int run(
+                size_t buffer_bytes,
+                size_t chunk_bytes,
+                unsigned int in_flight,
+                unsigned int repetitions);
+
+    private:
+        int stream(
+                std::vector<cl_float> const& input,
+                size_t chunk_bytes,
+                unsigned int in_flight,
+                uint64_t& time);
+
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+        cl::CommandQueue transfer_queue_;
+        cl::CommandQueue compute_queue_;
+        cl::Kernel kernel_;
+        PinnedPool pool_;
+    };
+}
+
+#endif /* STREAMING_HPP */
@@ -0,0 +1,108 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "thread_team.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+gpubench::ThreadTeam::ThreadTeam(unsigned int num_threads)
+    : task_(NULL), generation_(0), running_(0), stop_(false) {
+
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int t = 0; t < num_threads; ++t) {
+        threads_.push_back(std::thread(&ThreadTeam::work, this, t));
+    }
+}
+
+gpubench::ThreadTeam::~ThreadTeam() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+unsigned int gpubench::ThreadTeam::size() const {
+    return threads_.size();
+}
+
+void gpubench::ThreadTeam::run(std::function<void(unsigned int)> const& task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    task_ = &task;
+    running_ = threads_.size();
+    ++generation_;
+    start_.notify_all();
+
+    done_.wait(lock, [this] { return running_ == 0; });
+    task_ = NULL;
+}
+
+void gpubench::ThreadTeam::partition(
+        size_t n,
+        unsigned int num_threads,
+        unsigned int thread,
+        size_t alignment,
+        size_t& begin,
+        size_t& end) {
+    size_t blocks = (n + alignment - 1) / alignment;
+
+    begin = std::min(n, blocks * thread / num_threads * alignment);
+    end = std::min(n, blocks * (thread + 1) / num_threads * alignment);
+}
+
+void gpubench::ThreadTeam::work(unsigned int thread) {
+#ifdef __linux__
+    unsigned int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(thread % num_cpus, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+
+    unsigned long generation = 0;
+
+    for (;;) {
+        std::function<void(unsigned int)> const* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stop_ || generation_ != generation; });
+            if (stop_) {
+                return;
+            }
+            generation = generation_;
+            task = task_;
+        }
+
+        (*task)(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--running_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef THREAD_TEAM_HPP
+#define THREAD_TEAM_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gpubench {
+    /*
+     * Fixed team of host threads, each pinned to one CPU where supported
+     *
+     * Thread i always runs part i of a task, so memory first touched by
+     * thread i stays local to the NUMA node it runs on.
+     */
+    class ThreadTeam {
+    public:
+        // 0 threads uses all hardware threads
+        explicit ThreadTeam(unsigned int num_threads);
+        ~ThreadTeam();
+
+        ThreadTeam(ThreadTeam const&) = delete;
+        ThreadTeam& operator=(ThreadTeam const&) = delete;
+
+        unsigned int size() const;
+
+        // Run task(thread) on every thread and wait for all of them
+        void run(std::function<void(unsigned int)> const& task);
+
+        // Elements [begin, end) of n for thread, aligned to alignment elements
+        static void partition(
+                size_t n,
+                unsigned int num_threads,
+                unsigned int thread,
+                size_t alignment,
+                size_t& begin,
+                size_t& end);
+
+    private:
+        void work(unsigned int thread);
+
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable start_;
+        std::condition_variable done_;
+        std::function<void(unsigned int)> const* task_;
+        unsigned long generation_;
+        unsigned int running_;
+        bool stop_;
+    };
+}
+
+#endif /* THREAD_TEAM_HPP */
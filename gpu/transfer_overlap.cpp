@@ -0,0 +1,386 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "transfer_overlap.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+void gpubench::TransferOverlap::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::TransferOverlap::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::TransferOverlap::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+/*
+ * Enqueue the selected operations, each on its own queue slot, and wait
+ * for all of them. Returns the span from the earliest start to the latest
+ * end and the duration of each operation from event timestamps.
+ */
+int gpubench::TransferOverlap::run_operations(
+        unsigned int operations,
+        std::vector<cl::CommandQueue> const& queues,
+        uint64_t& span,
+        std::vector<uint64_t>& durations) {
+
+    size_t num_events = 0;
+
+    if (operations & HostToDevice) {
+        cl::Event event;
+        cle_sanitize_val_return(
+                queues[0].enqueueWriteBuffer(
+                    d_in_,
+                    CL_FALSE,
+                    0,
+                    transfer_bytes_,
+                    h_in_ptr_,
+                    NULL,
+                    &event));
+        profiler_->add_event("overlap H2D", event, transfer_bytes_);
+        ++num_events;
+    }
+
+    if (operations & DeviceToHost) {
+        cl::Event event;
+        cle_sanitize_val_return(
+                queues[1 % queues.size()].enqueueReadBuffer(
+                    d_out_,
+                    CL_FALSE,
+                    0,
+                    transfer_bytes_,
+                    h_out_ptr_,
+                    NULL,
+                    &event));
+        profiler_->add_event("overlap D2H", event, transfer_bytes_);
+        ++num_events;
+    }
+
+    if (operations & Compute) {
+        cl::Event event;
+        cle_sanitize_val_return(
+                queues[2 % queues.size()].enqueueNDRangeKernel(
+                    busy_kernel_,
+                    cl::NullRange,
+                    cl::NDRange(compute_size_),
+                    cl::NullRange,
+                    NULL,
+                    &event));
+        profiler_->add_event("overlap compute", event);
+        ++num_events;
+    }
+
+    // Submit to all queues before waiting on any of them
+    for (cl::CommandQueue const& queue : queues) {
+        cle_sanitize_val_return(
+                queue.flush());
+    }
+
+    cle_sanitize_val_return(
+            profiler_->collect(queues));
+
+    cl_ulong first_start = ~(cl_ulong) 0;
+    cl_ulong last_end = 0;
+
+    durations.clear();
+    for (Profiler::Record const& record : profiler_->last_records(num_events)) {
+        first_start = std::min(first_start, record.phases.start);
+        last_end = std::max(last_end, record.phases.end);
+        durations.push_back(record.execution_time());
+    }
+
+    span = last_end - first_start;
+
+    return 1;
+}
+
+int gpubench::TransferOverlap::run(size_t buffer_bytes, unsigned int repetitions) {
+
+    cl_int err;
+
+    cl_uint const calibration_iterations = 256;
+
+    cl::Device device = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    transfer_bytes_ = buffer_bytes;
+    compute_size_ = buffer_bytes / sizeof(cl_float);
+
+    // Pinned host buffers as transfer source and destination
+    cle::TypedBuffer<cl_float> h_in(
+            context_,
+            CL_MEM_ALLOC_HOST_PTR | CL_MEM_READ_WRITE,
+            compute_size_,
+            NULL
+            );
+
+    cle::TypedBuffer<cl_float> h_out(
+            context_,
+            CL_MEM_ALLOC_HOST_PTR | CL_MEM_READ_WRITE,
+            compute_size_,
+            NULL
+            );
+
+    cle::TypedBuffer<cl_float> d_in(
+            context_,
+            CL_MEM_READ_WRITE,
+            compute_size_,
+            NULL
+            );
+
+    cle::TypedBuffer<cl_float> d_out(
+            context_,
+            CL_MEM_READ_WRITE,
+            compute_size_,
+            NULL
+            );
+
+    cle::TypedBuffer<cl_float> d_compute(
+            context_,
+            CL_MEM_READ_WRITE,
+            compute_size_,
+            NULL
+            );
+
+    d_in_ = d_in;
+    d_out_ = d_out;
+
+    cle_sanitize_ref_return(
+            h_in_ptr_ = commandqueue_.enqueueMapBuffer(
+                h_in,
+                CL_TRUE,
+                CL_MAP_WRITE_INVALIDATE_REGION,
+                0,
+                h_in.bytes(),
+                0,
+                0,
+                &err),
+            err
+            );
+
+    cle_sanitize_ref_return(
+            h_out_ptr_ = commandqueue_.enqueueMapBuffer(
+                h_out,
+                CL_TRUE,
+                CL_MAP_WRITE_INVALIDATE_REGION,
+                0,
+                h_out.bytes(),
+                0,
+                0,
+                &err),
+            err
+            );
+
+    cle_sanitize_val_return(
+            commandqueue_.enqueueFillBuffer(
+                d_compute,
+                1.0f,
+                0,
+                d_compute.bytes(),
+                NULL,
+                NULL));
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device,
+                "overlap.cl",
+                NULL,
+                program
+                ));
+
+    cle_sanitize_ref_return(
+            busy_kernel_ = cl::Kernel(program, "busy", &err),
+            err
+            );
+    busy_kernel_.setArg(0, d_compute);
+
+    // In-order queues, one per operation type
+    std::vector<cl::CommandQueue> multi_queues;
+    for (int i = 0; i < 3; ++i) {
+        cl::CommandQueue queue;
+        cle_sanitize_ref_return(
+                queue = cl::CommandQueue(
+                    context_,
+                    device,
+                    CL_QUEUE_PROFILING_ENABLE,
+                    &err),
+                err
+                );
+        multi_queues.push_back(queue);
+    }
+
+    // Single out-of-order queue, if the device supports it
+    std::vector<cl::CommandQueue> ooo_queue;
+    {
+        cl::CommandQueue queue(
+                context_,
+                device,
+                CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+                &err);
+        if (err == CL_SUCCESS) {
+            ooo_queue.push_back(queue);
+        }
+        else {
+            std::cerr << "Out-of-order queue not supported, skipping" << std::endl;
+        }
+    }
+
+    std::vector<uint64_t> durations;
+    uint64_t span;
+    int ret;
+
+    // Scale the compute kernel to take about as long as one transfer,
+    // the first kernel run only warms up
+    busy_kernel_.setArg(1, calibration_iterations);
+    for (int i = 0; i < 2; ++i) {
+        ret = run_operations(Compute, multi_queues, span, durations);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    uint64_t compute_time = span;
+    ret = run_operations(HostToDevice, multi_queues, span, durations);
+    if (ret < 0) {
+        return ret;
+    }
+    uint64_t transfer_time = span;
+
+    cl_uint iterations = (cl_uint) std::max<uint64_t>(
+            1,
+            calibration_iterations * transfer_time / std::max<uint64_t>(compute_time, 1));
+    busy_kernel_.setArg(1, iterations);
+
+    int const num_workloads = 4;
+    unsigned int const workloads[] = {
+        HostToDevice | DeviceToHost,
+        HostToDevice | Compute,
+        DeviceToHost | Compute,
+        HostToDevice | DeviceToHost | Compute
+    };
+    char const* workload_names[] = {
+        "H2D+D2H",
+        "H2D+compute",
+        "D2H+compute",
+        "H2D+D2H+compute"
+    };
+
+    int const num_configs = 2;
+    char const* config_names[] = {"multiple in-order", "out-of-order"};
+    std::vector<cl::CommandQueue> const* configs[] = {&multi_queues, &ooo_queue};
+
+    profiler_->add_metadata("compute iterations", std::to_string(iterations));
+    profiler_->add_table(
+            "transfer overlap",
+            {"queues", "workload", "transfer bytes", "serial (us)",
+            "concurrent (us)", "aggregate GB/s", "overlap efficiency"});
+
+    for (int c = 0; c < num_configs; ++c) {
+        if (configs[c]->empty()) {
+            continue;
+        }
+
+        for (int w = 0; w < num_workloads; ++w) {
+            std::vector<uint64_t> serial_samples;
+            std::vector<uint64_t> concurrent_samples;
+            std::vector<uint64_t> longest_samples;
+
+            for (unsigned int r = 0; r < repetitions; ++r) {
+                // Serial baseline, one operation at a time
+                uint64_t serial = 0;
+                uint64_t longest = 0;
+                for (unsigned int op = HostToDevice; op <= Compute; op <<= 1) {
+                    if (workloads[w] & op) {
+                        ret = run_operations(op, *configs[c], span, durations);
+                        if (ret < 0) {
+                            return ret;
+                        }
+                        serial += durations[0];
+                        longest = std::max(longest, durations[0]);
+                    }
+                }
+
+                ret = run_operations(workloads[w], *configs[c], span, durations);
+                if (ret < 0) {
+                    return ret;
+                }
+
+                serial_samples.push_back(serial);
+                concurrent_samples.push_back(span);
+                longest_samples.push_back(longest);
+            }
+
+            GpuBench::Statistics serial = GpuBench::statistics(serial_samples);
+            GpuBench::Statistics concurrent = GpuBench::statistics(concurrent_samples);
+            GpuBench::Statistics longest = GpuBench::statistics(longest_samples);
+
+            size_t bytes = 0;
+            if (workloads[w] & HostToDevice) {
+                bytes += transfer_bytes_;
+            }
+            if (workloads[w] & DeviceToHost) {
+                bytes += transfer_bytes_;
+            }
+
+            // 1 if the concurrent span shrinks to the longest operation,
+            // 0 if the operations are fully serialized
+            double hideable = (double) serial.median - longest.median;
+            double efficiency = (hideable > 0)
+                ? ((double) serial.median - concurrent.median) / hideable
+                : 0;
+
+            profiler_->add_row({
+                    config_names[c],
+                    workload_names[w],
+                    bytes,
+                    serial.median / 1000.0,
+                    concurrent.median / 1000.0,
+                    concurrent.median ? (double) bytes / concurrent.median : 0,
+                    efficiency
+                    });
+        }
+    }
+
+    cle_sanitize_val_return(
+            commandqueue_.enqueueUnmapMemObject(
+                h_in,
+                h_in_ptr_,
+                NULL,
+                NULL
+                ));
+
+    cle_sanitize_val_return(
+            commandqueue_.enqueueUnmapMemObject(
+                h_out,
+                h_out_ptr_,
+                NULL,
+                NULL
+                ));
+
+    cle_sanitize_val_return(
+            commandqueue_.finish());
+
+    return 1;
+}
@@ -0,0 +1,60 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef TRANSFER_OVERLAP_HPP
+#define TRANSFER_OVERLAP_HPP
+
+#include "profiler.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    class TransferOverlap {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        int run(size_t buffer_bytes, unsigned int repetitions);
+
+    private:
+        enum Operation {
+            HostToDevice = 1,
+            DeviceToHost = 2,
+            Compute = 4
+        };
+
+        int run_operations(
+                unsigned int operations,
+                std::vector<cl::CommandQueue> const& queues,
+                uint64_t& span,
+                std::vector<uint64_t>& durations);
+
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+
+        size_t transfer_bytes_;
+        void *h_in_ptr_;
+        void *h_out_ptr_;
+        cl::Buffer d_in_;
+        cl::Buffer d_out_;
+        cl::Kernel busy_kernel_;
+        size_t compute_size_;
+    };
+}
+
+#endif /* TRANSFER_OVERLAP_HPP */
@@ -0,0 +1,181 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "variance_offload.hpp"
+#include "device_variance.hpp"
+#include "common.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <clext.hpp>
+
+#include <cle_math.h>
+#include <datagen.h>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+void gpubench::VarianceOffload::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::VarianceOffload::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::VarianceOffload::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+int gpubench::VarianceOffload::run(size_t buffer_bytes, unsigned int repetitions) {
+
+    cl_int err;
+
+    size_t const size = buffer_bytes / sizeof(cl_double);
+
+    DeviceVariance device_variance;
+    cle_sanitize_val_return(
+            device_variance.init(context_, commandqueue_));
+
+    cl::Buffer d_data;
+    cle_sanitize_ref_return(
+            d_data = cl::Buffer(
+                context_,
+                CL_MEM_READ_ONLY,
+                size * sizeof(cl_double),
+                NULL,
+                &err),
+            err
+            );
+
+    std::vector<double> data(size);
+
+    profiler_->add_table(
+            "variance",
+            {"dataset", "kernel", "variance", "relative error",
+            "kernel (us)", "kernel GB/s", "end-to-end (us)", "end-to-end GB/s"});
+
+    for (size_t d = 0; d < num_datasets; ++d) {
+        GpuBench::generate_dataset(d, data);
+
+        long double reference = GpuBench::reference_variance(data);
+
+        // CPU kernels, nothing to transfer
+        for (size_t f = 0; f < num_variance_functions; ++f) {
+            std::vector<uint64_t> times;
+            double variance = 0;
+
+            for (unsigned int r = 0; r < repetitions; ++r) {
+                std::chrono::steady_clock::time_point begin =
+                    std::chrono::steady_clock::now();
+
+                variance = variance_functions[f].function(data.data(), size);
+
+                std::chrono::steady_clock::time_point end =
+                    std::chrono::steady_clock::now();
+
+                times.push_back(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            end - begin).count());
+            }
+
+            GpuBench::Statistics time = GpuBench::statistics(times);
+            double gbs = time.median ? (double) buffer_bytes / time.median : 0;
+
+            profiler_->add_row({
+                    datasets[d].name,
+                    std::string("CPU ") + variance_functions[f].description,
+                    variance,
+                    GpuBench::relative_error(variance, reference),
+                    time.median / 1000.0,
+                    gbs,
+                    time.median / 1000.0,
+                    gbs
+                    });
+        }
+
+        // Device kernels, end-to-end includes the transfer and the host merge
+        for (int m = 0; m < DeviceVariance::num_methods; ++m) {
+            DeviceVariance::Method method = DeviceVariance::methods[m];
+            std::vector<uint64_t> kernel_times;
+            std::vector<uint64_t> total_times;
+            double variance = 0;
+
+            for (unsigned int r = 0; r < repetitions; ++r) {
+                cl::Event write_event;
+                cl::Event kernel_event;
+                cl::Event read_event;
+
+                std::chrono::steady_clock::time_point begin =
+                    std::chrono::steady_clock::now();
+
+                cle_sanitize_val_return(
+                        commandqueue_.enqueueWriteBuffer(
+                            d_data,
+                            CL_FALSE,
+                            0,
+                            size * sizeof(cl_double),
+                            data.data(),
+                            NULL,
+                            &write_event));
+
+                cle_sanitize_val_return(
+                        device_variance.reduce(
+                            method,
+                            d_data,
+                            size,
+                            kernel_event,
+                            read_event));
+
+                cle_sanitize_val_return(
+                        read_event.wait());
+
+                GpuBench::Moments moments = device_variance.moments(method);
+                variance = moments.m2 / moments.count;
+
+                std::chrono::steady_clock::time_point end =
+                    std::chrono::steady_clock::now();
+
+                profiler_->add_event("variance H2D", write_event, buffer_bytes);
+                profiler_->add_event(
+                        DeviceVariance::method_name(method), kernel_event, buffer_bytes);
+                profiler_->add_event("variance partials D2H", read_event);
+                cle_sanitize_val_return(
+                        profiler_->collect(commandqueue_));
+
+                kernel_times.push_back(profiler_->last_records(2).front().execution_time());
+                total_times.push_back(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            end - begin).count());
+            }
+
+            GpuBench::Statistics kernel_time = GpuBench::statistics(kernel_times);
+            GpuBench::Statistics total_time = GpuBench::statistics(total_times);
+
+            profiler_->add_row({
+                    datasets[d].name,
+                    DeviceVariance::method_name(method),
+                    variance,
+                    GpuBench::relative_error(variance, reference),
+                    kernel_time.median / 1000.0,
+                    kernel_time.median ? (double) buffer_bytes / kernel_time.median : 0,
+                    total_time.median / 1000.0,
+                    total_time.median ? (double) buffer_bytes / total_time.median : 0
+                    });
+        }
+    }
+
+    return 1;
+}
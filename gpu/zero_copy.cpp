@@ -0,0 +1,396 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#include "zero_copy.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <clext.hpp>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace {
+#ifdef CL_VERSION_2_0
+    // Frees an SVM allocation on every exit from run_path
+    class SvmFreeGuard {
+    public:
+        SvmFreeGuard(cl::Context const& context, void*& ptr)
+            : context_(context), ptr_(ptr) {}
+
+        ~SvmFreeGuard() {
+            if (ptr_ != NULL) {
+                clSVMFree(context_(), ptr_);
+            }
+        }
+
+    private:
+        cl::Context context_;
+        void*& ptr_;
+    };
+#endif
+}
+
+void gpubench::ZeroCopy::set_cl_context(cl::Context context) {
+    context_ = context;
+}
+
+void gpubench::ZeroCopy::set_cl_commandqueue(cl::CommandQueue queue) {
+    commandqueue_ = queue;
+}
+
+void gpubench::ZeroCopy::set_profiler(Profiler& profiler) {
+    profiler_ = &profiler;
+}
+
+bool gpubench::ZeroCopy::svm_supported(cl_bitfield capability) const {
+#ifdef CL_VERSION_2_0
+    std::string version = device_.getInfo<CL_DEVICE_VERSION>();
+    if (version.compare(0, 9, "OpenCL 1.") == 0) {
+        return false;
+    }
+
+    cl_device_svm_capabilities caps =
+        device_.getInfo<CL_DEVICE_SVM_CAPABILITIES>();
+
+    return (caps & capability) != 0;
+#else
+    (void) capability;
+    return false;
+#endif
+}
+
+/*
+ * Run the touch kernel on data that is already in host memory
+ *
+ * Buffer setup and producing the data in the path's host-visible memory
+ * are not timed. The total covers everything needed after that to get
+ * the kernel result: the copy for explicit copies, the unmap for mapped
+ * and coarse-grained SVM memory and the kernel itself.
+ *
+ * Returns 0 if the path is not supported by the device.
+ */
+int gpubench::ZeroCopy::run_path(
+        Path path,
+        cl_uint passes,
+        uint64_t& total,
+        uint64_t& kernel_time) {
+
+    cl_int err;
+
+    size_t const bytes = buffer_size_ * sizeof(cl_float);
+
+    cl::Buffer d_data;
+    cl_float *mapped_ptr = NULL;
+    void *svm_ptr = NULL;
+    cl::Event kernel_event;
+
+#ifdef CL_VERSION_2_0
+    SvmFreeGuard svm_guard(context_, svm_ptr);
+#endif
+
+    switch (path) {
+        case Path::ExplicitCopy:
+            cle_sanitize_ref_return(
+                    d_data = cl::Buffer(
+                        context_,
+                        CL_MEM_READ_ONLY,
+                        bytes,
+                        NULL,
+                        &err),
+                    err
+                    );
+            break;
+        case Path::UseHostPtr:
+            cle_sanitize_ref_return(
+                    d_data = cl::Buffer(
+                        context_,
+                        CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
+                        bytes,
+                        h_data_,
+                        &err),
+                    err
+                    );
+            break;
+        case Path::Mapped:
+            cle_sanitize_ref_return(
+                    d_data = cl::Buffer(
+                        context_,
+                        CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR,
+                        bytes,
+                        NULL,
+                        &err),
+                    err
+                    );
+
+            cle_sanitize_ref_return(
+                    mapped_ptr = (cl_float *) commandqueue_.enqueueMapBuffer(
+                        d_data,
+                        CL_TRUE,
+                        CL_MAP_WRITE_INVALIDATE_REGION,
+                        0,
+                        bytes,
+                        NULL,
+                        NULL,
+                        &err),
+                    err
+                    );
+
+            std::memcpy(mapped_ptr, h_data_, bytes);
+            break;
+        case Path::SvmCoarse:
+        case Path::SvmFine:
+#ifdef CL_VERSION_2_0
+            {
+                bool fine = (path == Path::SvmFine);
+
+                if (!svm_supported(fine
+                            ? CL_DEVICE_SVM_FINE_GRAIN_BUFFER
+                            : CL_DEVICE_SVM_COARSE_GRAIN_BUFFER)) {
+                    return 0;
+                }
+
+                svm_ptr = clSVMAlloc(
+                        context_(),
+                        CL_MEM_READ_ONLY | (fine ? CL_MEM_SVM_FINE_GRAIN_BUFFER : 0),
+                        bytes,
+                        0);
+                if (svm_ptr == NULL) {
+                    std::cerr << "SVM allocation failed" << std::endl;
+                    return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+                }
+
+                if (!fine) {
+                    cle_sanitize_val_return(
+                            clEnqueueSVMMap(
+                                commandqueue_(),
+                                CL_TRUE,
+                                CL_MAP_WRITE_INVALIDATE_REGION,
+                                svm_ptr,
+                                bytes,
+                                0,
+                                NULL,
+                                NULL));
+                }
+
+                std::memcpy(svm_ptr, h_data_, bytes);
+            }
+            break;
+#else
+            return 0;
+#endif
+    }
+
+    // Start of timed region
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    switch (path) {
+        case Path::ExplicitCopy:
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueWriteBuffer(
+                        d_data,
+                        CL_FALSE,
+                        0,
+                        bytes,
+                        h_data_,
+                        NULL,
+                        NULL));
+            cle_sanitize_val_return(
+                    kernel_.setArg(0, d_data));
+            break;
+        case Path::UseHostPtr:
+            cle_sanitize_val_return(
+                    kernel_.setArg(0, d_data));
+            break;
+        case Path::Mapped:
+            cle_sanitize_val_return(
+                    commandqueue_.enqueueUnmapMemObject(
+                        d_data,
+                        mapped_ptr,
+                        NULL,
+                        NULL));
+            cle_sanitize_val_return(
+                    kernel_.setArg(0, d_data));
+            break;
+        case Path::SvmCoarse:
+        case Path::SvmFine:
+#ifdef CL_VERSION_2_0
+            if (path == Path::SvmCoarse) {
+                cle_sanitize_val_return(
+                        clEnqueueSVMUnmap(
+                            commandqueue_(),
+                            svm_ptr,
+                            0,
+                            NULL,
+                            NULL));
+            }
+            cle_sanitize_val_return(
+                    clSetKernelArgSVMPointer(kernel_(), 0, svm_ptr));
+#endif
+            break;
+    }
+
+    cle_sanitize_val_return(
+            kernel_.setArg(3, passes));
+
+    cle_sanitize_val_return(
+            commandqueue_.enqueueNDRangeKernel(
+                kernel_,
+                cl::NullRange,
+                cl::NDRange(global_size_),
+                cl::NullRange,
+                NULL,
+                &kernel_event));
+
+    cle_sanitize_val_return(
+            commandqueue_.finish());
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    // End of timed region
+
+    total = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    profiler_->add_event("zero copy touch", kernel_event, bytes * passes);
+    cle_sanitize_val_return(
+            profiler_->collect(commandqueue_));
+    kernel_time = profiler_->last_records(1).front().execution_time();
+
+    return 1;
+}
+
+int gpubench::ZeroCopy::run(size_t buffer_bytes, unsigned int repetitions) {
+
+    cl_int err;
+    int ret;
+
+    size_t const page_size = 4096;
+    size_t const max_global_size = 1 << 16;
+
+    buffer_size_ = buffer_bytes / sizeof(cl_float);
+    global_size_ = std::min(buffer_size_, max_global_size);
+    device_ = commandqueue_.getInfo<CL_QUEUE_DEVICE>();
+
+    cl::Program program;
+    cle_sanitize_val_return(
+            GpuBench::build_program(
+                context_,
+                device_,
+                "zero_copy.cl",
+                NULL,
+                program
+                ));
+
+    cle_sanitize_ref_return(
+            kernel_ = cl::Kernel(program, "touch", &err),
+            err
+            );
+
+    cle::TypedBuffer<cl_float> d_result(
+            context_,
+            CL_MEM_WRITE_ONLY,
+            global_size_,
+            NULL
+            );
+
+    kernel_.setArg(1, d_result);
+    kernel_.setArg(2, (cl_uint) buffer_size_);
+
+    // Page aligned, so that CL_MEM_USE_HOST_PTR can avoid a copy. Allocated
+    // after the program setup, whose early returns would not free it.
+    if (posix_memalign((void **) &h_data_, page_size, buffer_bytes) != 0) {
+        std::cerr << "Failed to allocate host buffer" << std::endl;
+        return CL_OUT_OF_HOST_MEMORY;
+    }
+    std::fill(h_data_, h_data_ + buffer_size_, 1.0f);
+
+    int const num_paths = 5;
+    Path const paths[] = {
+        Path::ExplicitCopy,
+        Path::UseHostPtr,
+        Path::Mapped,
+        Path::SvmCoarse,
+        Path::SvmFine
+    };
+    char const* path_names[] = {
+        "explicit copy",
+        "use host ptr",
+        "mapped",
+        "svm coarse grain",
+        "svm fine grain"
+    };
+
+    int const num_passes = 3;
+    cl_uint const passes[] = {1, 4, 16};
+
+    profiler_->add_table(
+            "zero copy",
+            {"path", "passes", "bytes", "total (us)", "kernel (us)",
+             "kernel GB/s", "total GB/s"});
+
+    for (int p = 0; p < num_paths; ++p) {
+        for (int n = 0; n < num_passes; ++n) {
+            std::vector<uint64_t> totals;
+            std::vector<uint64_t> kernel_times;
+
+            for (unsigned int r = 0; r < repetitions; ++r) {
+                uint64_t total;
+                uint64_t kernel_time;
+
+                ret = run_path(paths[p], passes[n], total, kernel_time);
+                if (ret < 0) {
+                    free(h_data_);
+                    return ret;
+                }
+                if (ret == 0) {
+                    break;
+                }
+
+                totals.push_back(total);
+                kernel_times.push_back(kernel_time);
+            }
+
+            if (totals.empty()) {
+                std::cerr << path_names[p] << " not supported, skipping" << std::endl;
+                break;
+            }
+
+            GpuBench::Statistics total = GpuBench::statistics(totals);
+            GpuBench::Statistics kernel_time = GpuBench::statistics(kernel_times);
+
+            // Both bandwidths count every pass. The kernel bandwidth uses
+            // the kernel time only, the total bandwidth the end-to-end time
+            // including the copy or unmap.
+            size_t bytes = buffer_bytes * passes[n];
+
+            profiler_->add_row({
+                    path_names[p],
+                    passes[n],
+                    buffer_bytes,
+                    total.median / 1000.0,
+                    kernel_time.median / 1000.0,
+                    kernel_time.median ? (double) bytes / kernel_time.median : 0,
+                    total.median ? (double) bytes / total.median : 0
+                    });
+        }
+    }
+
+    free(h_data_);
+
+    return 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public License,
+ * v. 2.0. If a copy of the MPL was not distributed with this file, You can
+ * obtain one at http://mozilla.org/MPL/2.0/.
+ * 
+ * 
+ * Copyright (c) 2016, Lutz, Clemens <lutzcle@cml.li>
+ */
+
+#ifndef ZERO_COPY_HPP
+#define ZERO_COPY_HPP
+
+#include "profiler.hpp"
+
+#include <cstdint>
+
+#ifdef MAC
+#include <OpenCL/cl.hpp>
+#else
+#include <CL/cl.hpp>
+#endif
+
+namespace gpubench {
+    class ZeroCopy {
+    public:
+        void set_cl_context(cl::Context context);
+        void set_cl_commandqueue(cl::CommandQueue queue);
+        void set_profiler(Profiler& profiler);
+
+        int run(size_t buffer_bytes, unsigned int repetitions);
+
+    private:
+        enum class Path {
+            ExplicitCopy,
+            UseHostPtr,
+            Mapped,
+            SvmCoarse,
+            SvmFine
+        };
+
+        int run_path(
+                Path path,
+                cl_uint passes,
+                uint64_t& total,
+                uint64_t& kernel_time);
+
+        bool svm_supported(cl_bitfield capability) const;
+
+        cl::Context context_;
+        cl::CommandQueue commandqueue_;
+        Profiler *profiler_;
+        cl::Device device_;
+        cl::Kernel kernel_;
+
+        size_t buffer_size_;
+        size_t global_size_;
+        cl_float *h_data_;
+    };
+}
+
+#endif /* ZERO_COPY_HPP */
@@ -0,0 +1,262 @@
+#include "approx.h"
+#include "cle_math.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Means and variances of the blocks sampled so far
+ */
+typedef struct BlockMoments {
+    size_t blocks;
+    double *m;
+    double *v;
+} BlockMoments;
+
+void approx_default_options(ApproxOptions * options) {
+    options->block_size = APPROX_BLOCK_PAGE;
+    options->initial_blocks = 64;
+    options->confidence = 0.95;
+    options->error_bound = 0.01;
+    options->seed = 1;
+}
+
+/*
+ * Pseudo-random bijection on [0, 2^bits)
+ * Every step (xor with a constant, xorshift, multiplication by an odd
+ * number modulo 2^bits) is invertible, so no index is drawn twice.
+ */
+static uint64_t permute_bits(uint64_t x, unsigned int bits, uint64_t key) {
+    uint64_t const mask = (bits == 64) ? UINT64_MAX : (((uint64_t) 1 << bits) - 1);
+    unsigned int const shift = bits / 2 + 1;
+
+    for (int round = 0; round != 3; ++round) {
+        x = (x ^ key) & mask;
+        x ^= x >> shift;
+        x = (x * 0x9E3779B97F4A7C15ull) & mask;
+        key = key * 6364136223846793005ull + 1442695040888963407ull;
+    }
+
+    return x;
+}
+
+/*
+ * Position i of a random permutation of [0, n)
+ * Cycle-walks the bijection on the next power of two until it lands in range
+ */
+static size_t permute(size_t i, size_t n, unsigned int bits, uint64_t key) {
+    uint64_t x = i;
+
+    do {
+        x = permute_bits(x, bits, key);
+    } while (x >= n);
+
+    return x;
+}
+
+static int compare_size(void const* a, void const* b) {
+    size_t _a = *(size_t const*) a;
+    size_t _b = *(size_t const*) b;
+    return (_a > _b) - (_a < _b);
+}
+
+/*
+ * Two-sided standard normal quantile for the given confidence level
+ * Abramowitz and Stegun 26.2.23, absolute error < 4.5e-4
+ */
+static double normal_quantile(double confidence) {
+    double p = (1 - confidence) / 2;
+    double t = sqrt(-2 * log(p));
+
+    return t - (2.515517 + 0.802853 * t + 0.010328 * t * t)
+        / (1 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+}
+
+/*
+ * Resize array to hold count elements
+ * Returns 0 on allocation failure, leaving the array untouched
+ */
+static int grow(void * array, size_t element_size, size_t count) {
+    void *resized = realloc(*(void **) array, element_size * (count + 1));
+
+    if (resized == NULL) {
+        return 0;
+    }
+
+    *(void **) array = resized;
+
+    return 1;
+}
+
+/*
+ * Sample the next batch of blocks in address order and record their moments
+ */
+static void sample_blocks(double const* x, size_t block_size, VarianceFunc kernel,
+        size_t * batch, size_t batch_size, BlockMoments * moments) {
+    qsort(batch, batch_size, sizeof(size_t), compare_size);
+
+    for (size_t i = 0; i != batch_size; ++i) {
+        double const* block = &x[batch[i] * block_size];
+
+        moments->m[moments->blocks] = mean(block, block_size);
+        moments->v[moments->blocks] = kernel(block, block_size);
+        moments->blocks += 1;
+    }
+}
+
+/*
+ * Approximate variance from a random sample of equally sized blocks
+ *
+ * The variance of the full blocks is the mean within-block variance plus
+ * the variance of the block means. Per-block variances come from the given
+ * kernel. Blocks are sampled without replacement and the values after the
+ * last full block are always included exactly and merged with Chan's
+ * formula. The confidence interval is based on the per-block influence
+ * v_b + (m_b - m)^2 with finite population correction. If an error bound
+ * is given, the sample is doubled until the relative half width of the
+ * interval is within the bound or all blocks have been read.
+ */
+int variance_approx(double const* x, size_t n, VarianceFunc kernel,
+        ApproxOptions const* options, ApproxVariance * result) {
+    size_t const block_size = options->block_size;
+    size_t const total_blocks = (block_size == 0) ? 0 : n / block_size;
+    size_t const full_size = total_blocks * block_size;
+    size_t const tail_size = n - full_size;
+    double const z = normal_quantile(options->confidence);
+    double tail_m = 0;
+    double tail_v = 0;
+    size_t batch_size = options->initial_blocks;
+    size_t *batch = NULL;
+    uint64_t const key = options->seed * 0x9E3779B97F4A7C15ull + 1;
+    unsigned int bits = 1;
+    int ret = 1;
+    BlockMoments moments = {0};
+
+    /* Left NaN on errors before the first round completes */
+    result->variance = NAN;
+    result->lower = NAN;
+    result->upper = NAN;
+    result->sampled_blocks = 0;
+    result->total_blocks = total_blocks;
+    result->rounds = 0;
+
+    if (block_size == 0 || n == 0) {
+        return -1;
+    }
+
+    if (batch_size == 0) {
+        batch_size = 1;
+    }
+
+    if (tail_size != 0) {
+        tail_m = mean(&x[full_size], tail_size);
+        tail_v = kernel(&x[full_size], tail_size);
+    }
+
+    while (bits < 64 && ((uint64_t) 1 << bits) < total_blocks) {
+        ++bits;
+    }
+
+    do {
+        size_t const start = moments.blocks;
+        double k = 0;
+        double full_m = 0;
+        double full_v = 0;
+        double within = 0;
+        double between = 0;
+        double z_mean = 0;
+        double z_var = 0;
+        double half_width = 0;
+
+        if (batch_size > total_blocks - start) {
+            batch_size = total_blocks - start;
+        }
+
+        /* Buffers grow with the sample, not with the input */
+        if (!grow(&batch, sizeof(size_t), batch_size)
+                || !grow((void *) &moments.m, sizeof(double), start + batch_size)
+                || !grow((void *) &moments.v, sizeof(double), start + batch_size)) {
+            ret = -1;
+            break;
+        }
+
+        for (size_t i = 0; i != batch_size; ++i) {
+            batch[i] = permute(start + i, total_blocks, bits, key);
+        }
+        sample_blocks(x, block_size, kernel, batch, batch_size, &moments);
+
+        k = moments.blocks;
+        if (k != 0) {
+            for (size_t i = 0; i != moments.blocks; ++i) {
+                full_m += moments.m[i];
+                within += moments.v[i];
+            }
+            full_m /= k;
+            within /= k;
+
+            for (size_t i = 0; i != moments.blocks; ++i) {
+                double d = moments.m[i] - full_m;
+                between += d * d;
+                z_mean += moments.v[i] + d * d;
+            }
+            between /= k;
+            z_mean /= k;
+            full_v = within + between;
+
+            if (k > 1) {
+                for (size_t i = 0; i != moments.blocks; ++i) {
+                    double d = moments.m[i] - full_m;
+                    double dz = moments.v[i] + d * d - z_mean;
+                    z_var += dz * dz;
+                }
+                z_var /= k - 1;
+            }
+        }
+
+        if (moments.blocks == total_blocks) {
+            half_width = 0;
+        }
+        else if (k > 1) {
+            half_width = z * sqrt(z_var / k * (1 - k / total_blocks))
+                * full_size / n;
+        }
+        else {
+            half_width = INFINITY;
+        }
+
+        /* Chan et al. merge of the sampled full blocks and the exact tail */
+        if (tail_size == 0) {
+            result->variance = full_v;
+        }
+        else if (k == 0) {
+            result->variance = tail_v;
+        }
+        else {
+            double d = full_m - tail_m;
+            result->variance = (full_size * full_v + tail_size * tail_v) / n
+                + d * d * ((double) full_size / n) * ((double) tail_size / n);
+        }
+        result->lower = result->variance - half_width;
+        result->upper = result->variance + half_width;
+        result->sampled_blocks = moments.blocks;
+        result->rounds += 1;
+
+        if (options->error_bound <= 0
+                || half_width <= options->error_bound * fabs(result->variance)) {
+            break;
+        }
+
+        batch_size = moments.blocks;
+    } while (moments.blocks != total_blocks);
+
+    if (ret > 0 && result->lower < 0) {
+        result->lower = 0;
+    }
+
+    free(batch);
+    free(moments.m);
+    free(moments.v);
+
+    return ret;
+}
@@ -0,0 +1,35 @@
+#ifndef APPROX_H
+#define APPROX_H
+
+#include "cle_math.h"
+
+#include <stddef.h> /* size_t */
+
+/* Block sizes in values that keep sampled reads sequential */
+#define APPROX_BLOCK_CACHE_LINE (64 / sizeof(double))
+#define APPROX_BLOCK_PAGE (4096 / sizeof(double))
+
+typedef struct ApproxOptions {
+    size_t block_size;      /* values per sampled block */
+    size_t initial_blocks;  /* blocks sampled in the first round */
+    double confidence;      /* confidence level of the interval, e.g. 0.95 */
+    double error_bound;     /* relative interval half width to refine to,
+                               <= 0 for a single round */
+    unsigned int seed;
+} ApproxOptions;
+
+typedef struct ApproxVariance {
+    double variance;
+    double lower;           /* confidence interval bounds */
+    double upper;
+    size_t sampled_blocks;
+    size_t total_blocks;
+    size_t rounds;
+} ApproxVariance;
+
+void approx_default_options(ApproxOptions * options);
+
+int variance_approx(double const* values, size_t size, VarianceFunc kernel,
+        ApproxOptions const* options, ApproxVariance * result);
+
+#endif /* APPROX_H */
@@ -0,0 +1,91 @@
+#include "approx.h"
+#include "cle_math.h"
+#include "datagen.h"
+#include "timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RUNS 5
+#define SIZE ((1L << 17) * 1000) /* 1 GB */
+#define ALIGNMENT 4096 /* page aligned blocks */
+
+/*
+ * Time-to-answer of the approximate variance against the requested
+ * relative error bound, compared to an exact scan with the same kernel
+ */
+int main() {
+    double *vals = NULL;
+    double const error_bounds[] = {0.1, 0.05, 0.01, 0.005, 0.001, 0.0005};
+    size_t const num_error_bounds = sizeof(error_bounds) / sizeof(double);
+    size_t const block_sizes[] = {APPROX_BLOCK_CACHE_LINE, APPROX_BLOCK_PAGE};
+    size_t const num_block_sizes = sizeof(block_sizes) / sizeof(size_t);
+    VarianceFunc const kernel = &variance_onepass;
+    ApproxOptions options;
+    ApproxVariance result;
+    cle_timer_t _timer;
+    uint64_t exact_time = 0;
+    double exact = 0;
+
+    if (posix_memalign((void*)&vals, ALIGNMENT, SIZE * sizeof(double)) != 0) {
+        fprintf(stderr, "Failed to malloc value array\n");
+        return 1;
+    }
+
+    srand(time(NULL));
+    gen_approx_equal(vals, SIZE);
+
+    /* Exact scan, also warms up the page tables */
+    exact = kernel(vals, SIZE);
+    for (size_t r = 0; r != RUNS; ++r) {
+        _timer = timer_start();
+        exact = kernel(vals, SIZE);
+        exact_time += timer_stop(_timer);
+    }
+    exact_time /= RUNS;
+
+    printf("block_values,error_bound,time_us,speedup,variance,lower,upper,"
+            "relative_error,in_interval,sampled_blocks,total_blocks,rounds\n");
+    printf("%ld,0,%lu,1,%.17g,%.17g,%.17g,0,1,0,0,1\n",
+            SIZE, exact_time / 1000, exact, exact, exact);
+
+    approx_default_options(&options);
+
+    for (size_t b = 0; b != num_block_sizes; ++b) {
+        for (size_t e = 0; e != num_error_bounds; ++e) {
+            uint64_t run_time = 0;
+            double error = 0;
+
+            options.block_size = block_sizes[b];
+            options.error_bound = error_bounds[e];
+
+            for (size_t r = 0; r != RUNS; ++r) {
+                options.seed = r + 1;
+                _timer = timer_start();
+                if (variance_approx(vals, SIZE, kernel, &options, &result) < 0) {
+                    fprintf(stderr, "Approximate variance failed\n");
+                    free(vals);
+                    return 1;
+                }
+                run_time += timer_stop(_timer);
+            }
+            run_time /= RUNS;
+
+            error = (result.variance - exact) / exact;
+            if (error < 0) {
+                error = -error;
+            }
+
+            printf("%zu,%g,%lu,%.1f,%.17g,%.17g,%.17g,%g,%d,%zu,%zu,%zu\n",
+                    block_sizes[b], error_bounds[e], run_time / 1000,
+                    (double) exact_time / (run_time ? run_time : 1),
+                    result.variance, result.lower, result.upper, error,
+                    result.lower <= exact && exact <= result.upper,
+                    result.sampled_blocks, result.total_blocks,
+                    result.rounds);
+        }
+    }
+
+    free(vals);
+}
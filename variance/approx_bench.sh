@@ -0,0 +1,3 @@
+#!/bin/bash
+
+clang -O2 -msse4.1 -o approx_bench -lm timer.c cle_math.c datagen.c approx.c approx_bench.c
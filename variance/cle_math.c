@@ -7,6 +7,18 @@
 
 #define DOUBLE_ABS_MASK 0x7FFFFFFFFFFFFFFF
 
+FuncDesc const variance_functions[] = {
+    {&variance_onepass, "OnePass"},
+    {&variance_onepass_sse3, "OnePassSSE3"},
+    {&variance_onepass_kbn, "OnePassKBN"},
+    {&variance_onepass_kbn_sse4_1, "OnePassKBNSSE4.1"},
+    {&variance_onepass_naive, "OnePassNaive"},
+    {&variance_welford, "Welford"},
+    {&variance_twopass, "TwoPass"}
+};
+
+size_t const num_variance_functions = sizeof(variance_functions) / sizeof(FuncDesc);
+
 /*
  * Calculate variance
  * Uses Kahan summation algorithm
@@ -3,6 +3,16 @@
 
 #include <stddef.h> /* size_t */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef double (*VarianceFunc)(double const*, size_t);
+typedef struct FuncDesc {
+    VarianceFunc function;
+    char const* description;
+} FuncDesc;
+
 double mean(double const* values, size_t size);
 
 double variance_onepass(double const* values, size_t size);
@@ -13,4 +23,11 @@ double variance_onepass_naive(double const* values, size_t size);
 double variance_twopass(double const* values, size_t size);
 double variance_welford(double const* values, size_t size);
 
+extern FuncDesc const variance_functions[];
+extern size_t const num_variance_functions;
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* CLE_MATH_H */
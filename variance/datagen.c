@@ -0,0 +1,70 @@
+#include "datagen.h"
+
+#include <stdlib.h>
+
+DataDesc const datasets[] = {
+    {&gen_random, "random", "Random"},
+    {&gen_approx_equal, "approx_equal", "Approximately equal with small variance"},
+    {&gen_ascending, "ascending", "Ascending"},
+    {&gen_descending, "descending", "Descending"},
+    {&gen_alternating, "alternating", "Alternating"}
+};
+
+size_t const num_datasets = sizeof(datasets) / sizeof(DataDesc);
+
+/*
+ * Random values
+ * Note: caller is responsible for seeding rand()
+ */
+void gen_random(double * vals, size_t n) {
+    for (size_t i = 0; i != n; ++i) {
+        vals[i] = rand();
+    }
+}
+
+/*
+ * Large but nearly equal values
+ * for large sum of squares but small variance
+ */
+void gen_approx_equal(double * vals, size_t n) {
+    const double LARGE_NUMBER = 10000000;
+    const int SMALL_VARIANCE = 100;
+    for (size_t i = 0; i != n; ++i) {
+        vals[i] = LARGE_NUMBER - rand() % SMALL_VARIANCE;
+    }
+}
+
+/*
+ * Ascending values
+ */
+void gen_ascending(double * vals, size_t n) {
+    for (size_t i = 0; i != n; ++i) {
+        vals[i] = i;
+    }
+}
+
+/*
+ * Descending values
+ */
+void gen_descending(double * vals, size_t n) {
+    for (size_t i = 0; i != n; ++i) {
+        vals[i] = (n / 2) * (n - 1) - ((i / 2) * (i - 1));
+    }
+}
+
+/*
+ * Alternating large and small values
+ */
+void gen_alternating(double * vals, size_t n) {
+    const double LARGE_NUMBER = 10000000;
+    const double SMALL_NUMBER = 100;
+    const int VARIANCE = 100;
+    for (size_t i = 0; i != n; ++i) {
+        if (i % 2 == 0) {
+            vals[i] = LARGE_NUMBER - rand() % VARIANCE;
+        }
+        else {
+            vals[i] = SMALL_NUMBER - rand() % VARIANCE;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <stddef.h> /* size_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*GenFunc)(double *, size_t);
+typedef struct DataDesc {
+    GenFunc generate;
+    char const* name;
+    char const* description;
+} DataDesc;
+
+void gen_random(double * values, size_t size);
+void gen_approx_equal(double * values, size_t size);
+void gen_ascending(double * values, size_t size);
+void gen_descending(double * values, size_t size);
+void gen_alternating(double * values, size_t size);
+
+extern DataDesc const datasets[];
+extern size_t const num_datasets;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATAGEN_H */
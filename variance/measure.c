@@ -1,8 +1,10 @@
 #include "cle_math.h"
+#include "datagen.h"
 #include "timer.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #define RUNS 10
 #define SIZE ((1L << 17) * 100) /* 100 MB */
@@ -34,27 +36,14 @@ int main() {
         fprintf(stderr, "Failed to malloc value array\n");
     }
 
-    printf("OnePass\n");
-    timed_run(&variance_onepass, RUNS, vals, SIZE);
+    /* Time on defined values rather than whatever the allocator returned */
+    srand(time(NULL));
+    gen_random(vals, SIZE);
 
-    printf("\nOnePassSSE3\n");
-    timed_run(&variance_onepass_sse3, RUNS, vals, SIZE);
-
-    printf("\nOnePassKBN\n");
-    timed_run(&variance_onepass_kbn, RUNS, vals, SIZE);
-
-    printf("\nOnePassKBNSSE4.1\n");
-    timed_run(&variance_onepass_kbn_sse4_1, RUNS, vals, SIZE);
-
-    printf("\nOnePassNaive\n");
-    timed_run(&variance_onepass_naive, RUNS, vals, SIZE);
-
-    printf("\nTwoPass\n");
-    timed_run(&variance_twopass, RUNS, vals, SIZE);
-
-    printf("\nWelford\n");
-    timed_run(&variance_welford, RUNS, vals, SIZE);
+    for (size_t i = 0; i != num_variance_functions; ++i) {
+        printf("%s%s\n", (i == 0) ? "" : "\n", variance_functions[i].description);
+        timed_run(variance_functions[i].function, RUNS, vals, SIZE);
+    }
 
     free(vals);
 }
-
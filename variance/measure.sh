@@ -1,3 +1,3 @@
 #!/bin/bash
 
-clang -O2 -msse4.1 -o measure -lm timer.c cle_math.c measure.c
+clang -O2 -msse4.1 -o measure -lm timer.c cle_math.c datagen.c measure.c
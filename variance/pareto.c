@@ -0,0 +1,174 @@
+#include "cle_math.h"
+#include "datagen.h"
+#include "reference.h"
+#include "timer.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RUNS 10
+#define SIZE 1000000
+#define SEED 42
+#define ALIGNMENT 16 /* satisfy 16-byte alignment for SSE2 load instructions */
+
+typedef struct KernelResult {
+    double variance;
+    uint64_t mean_ns;
+    double gb_per_s;
+    double relative_error;
+    uint64_t ulp_error;
+    bool pareto;
+} KernelResult;
+
+/*
+ * Mean run time in nanoseconds after one warm up run
+ */
+uint64_t timed_run(VarianceFunc f, size_t runs, double const* vals, size_t n,
+        double *variance) {
+    cle_timer_t _timer;
+    uint64_t run_time = 0;
+
+    *variance = f(vals, n);
+
+    for (size_t r = 0; r != runs; ++r) {
+        _timer = timer_start();
+        *variance = f(vals, n);
+        run_time += timer_stop(_timer);
+    }
+
+    return run_time / runs;
+}
+
+/*
+ * a dominates b if it is at least as fast and at least as accurate,
+ * and strictly better in one of both
+ */
+bool dominates(KernelResult const* a, KernelResult const* b) {
+    bool no_worse = a->gb_per_s >= b->gb_per_s
+        && a->relative_error <= b->relative_error;
+    bool better = a->gb_per_s > b->gb_per_s
+        || a->relative_error < b->relative_error;
+
+    return no_worse && better;
+}
+
+void mark_pareto(KernelResult * results, size_t num_results) {
+    for (size_t i = 0; i != num_results; ++i) {
+        results[i].pareto = true;
+        for (size_t j = 0; j != num_results; ++j) {
+            if (j != i && dominates(&results[j], &results[i])) {
+                results[i].pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * JSON has no representation for inf and NaN
+ */
+void print_json_double(double d) {
+    if (isfinite(d)) {
+        printf("%.17g", d);
+    }
+    else {
+        printf("null");
+    }
+}
+
+void print_dataset(DataDesc const* data, double reference,
+        KernelResult const* results, bool last) {
+    bool first = true;
+
+    printf("    {\n");
+    printf("      \"name\": \"%s\",\n", data->name);
+    printf("      \"description\": \"%s\",\n", data->description);
+    printf("      \"reference\": ");
+    print_json_double(reference);
+    printf(",\n");
+    printf("      \"kernels\": [\n");
+    for (size_t i = 0; i != num_variance_functions; ++i) {
+        printf("        {\"name\": \"%s\", \"variance\": ",
+                variance_functions[i].description);
+        print_json_double(results[i].variance);
+        printf(", \"mean_ns\": %lu, \"gb_per_s\": ", results[i].mean_ns);
+        print_json_double(results[i].gb_per_s);
+        printf(", \"relative_error\": ");
+        print_json_double(results[i].relative_error);
+        printf(", \"ulp_error\": ");
+        if (results[i].ulp_error == UINT64_MAX) {
+            printf("null");
+        }
+        else {
+            printf("%lu", results[i].ulp_error);
+        }
+        printf(", \"pareto\": %s}%s\n",
+                results[i].pareto ? "true" : "false",
+                (i == num_variance_functions - 1) ? "" : ",");
+    }
+    printf("      ],\n");
+    printf("      \"pareto_frontier\": [");
+    for (size_t i = 0; i != num_variance_functions; ++i) {
+        if (results[i].pareto) {
+            printf("%s\"%s\"", first ? "" : ", ",
+                    variance_functions[i].description);
+            first = false;
+        }
+    }
+    printf("]\n");
+    printf("    }%s\n", last ? "" : ",");
+}
+
+/*
+ * Run every kernel on every generated data set and report throughput
+ * and accuracy against the exact GMP result as JSON.
+ * Kernels on the Pareto frontier of throughput and relative error
+ * are flagged per data set.
+ */
+int main() {
+    double *vals = NULL;
+    KernelResult results[num_variance_functions];
+
+    if (posix_memalign((void*)&vals, ALIGNMENT, SIZE * sizeof(double)) != 0) {
+        fprintf(stderr, "Failed to malloc value array\n");
+        return 1;
+    }
+
+    srand(SEED);
+
+    printf("{\n");
+    printf("  \"size\": %d,\n", SIZE);
+    printf("  \"runs\": %d,\n", RUNS);
+    printf("  \"seed\": %d,\n", SEED);
+    printf("  \"datasets\": [\n");
+
+    for (size_t d = 0; d != num_datasets; ++d) {
+        double reference = 0;
+
+        datasets[d].generate(vals, SIZE);
+        reference = variance_gmp(vals, SIZE);
+
+        for (size_t i = 0; i != num_variance_functions; ++i) {
+            KernelResult *r = &results[i];
+
+            r->mean_ns = timed_run(variance_functions[i].function, RUNS,
+                    vals, SIZE, &r->variance);
+            r->gb_per_s = (double) (SIZE * sizeof(double)) / r->mean_ns;
+            r->relative_error = relative_error(r->variance, reference);
+            r->ulp_error = ulp_distance(r->variance, reference);
+            if (isnan(r->relative_error)) {
+                r->relative_error = INFINITY;
+            }
+        }
+
+        mark_pareto(results, num_variance_functions);
+        print_dataset(&datasets[d], reference, results, d == num_datasets - 1);
+    }
+
+    printf("  ]\n");
+    printf("}\n");
+
+    free(vals);
+}
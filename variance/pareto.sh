@@ -0,0 +1,3 @@
+#!/bin/bash
+
+gcc -O2 -msse4.1 -o pareto -lm -lgmp timer.c cle_math.c datagen.c reference.c pareto.c
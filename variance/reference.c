@@ -0,0 +1,116 @@
+#include "reference.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gmp.h>
+
+/*
+ * Calculate variance
+ * Note: GMP is an arbitrary precision math library - this is base of comparision
+ */
+double variance_gmp(double const* vals, size_t n) {
+    mpq_t _qn;
+    mpq_t _mean;
+    mpq_t _sum;
+    mpq_t _difference;
+    mpq_t _square;
+    mpq_t _variance;
+    double _dvariance = 0;
+
+    mpq_t *_qvals = malloc(sizeof(mpq_t) * n);
+    if (_qvals == NULL) {
+        fprintf(stderr, "Couldn't allocate qvals\n");
+    }
+
+    /* Convert to GMP rational type */
+    mpq_init(_qn);
+    mpq_set_ui(_qn, n, 1);
+    for (size_t i = 0; i != n; ++i) {
+        mpq_init(_qvals[i]);
+        mpq_set_d(_qvals[i], vals[i]);
+    }
+
+    /* Calculate mean */
+    mpq_init(_mean);
+    for (size_t i = 0; i != n; ++i) {
+        mpq_add(_mean, _mean, _qvals[i]);
+    }
+    mpq_div(_mean, _mean, _qn);
+
+    /* Calculate variance */
+    mpq_init(_sum);
+    mpq_init(_difference);
+    mpq_init(_square);
+    for (size_t i = 0; i != n; ++i) {
+        mpq_sub(_difference, _qvals[i], _mean);
+        mpq_mul(_square, _difference, _difference);
+        mpq_add(_sum, _sum, _square);
+    }
+
+    mpq_init(_variance);
+    mpq_div(_variance, _sum, _qn);
+
+    /* Convert to double */
+    _dvariance = mpq_get_d(_variance);
+
+    /* Free space */
+    for (size_t i = 0; i != n; ++i) {
+        mpq_clear(_qvals[i]);
+    }
+    free(_qvals);
+    mpq_clear(_qn);
+    mpq_clear(_mean);
+    mpq_clear(_sum);
+    mpq_clear(_difference);
+    mpq_clear(_square);
+    mpq_clear(_variance);
+
+    return _dvariance;
+}
+
+/*
+ * Relative error of value against reference
+ * Falls back to the absolute error if reference is zero
+ */
+double relative_error(double value, double reference) {
+    double _error = fabs(value - reference);
+
+    if (reference != 0) {
+        _error /= fabs(reference);
+    }
+
+    return _error;
+}
+
+/*
+ * Map the bit pattern of a double to an integer that is monotonic in the
+ * value, i.e. adjacent doubles map to adjacent integers
+ */
+static int64_t ordered_bits(double d) {
+    int64_t _bits = 0;
+
+    memcpy(&_bits, &d, sizeof(_bits));
+
+    return (_bits < 0) ? INT64_MIN - _bits : _bits;
+}
+
+/*
+ * Number of representable doubles between a and b
+ * Returns UINT64_MAX if either is NaN
+ */
+uint64_t ulp_distance(double a, double b) {
+    int64_t _a = 0;
+    int64_t _b = 0;
+
+    if (isnan(a) || isnan(b)) {
+        return UINT64_MAX;
+    }
+
+    _a = ordered_bits(a);
+    _b = ordered_bits(b);
+
+    return (_a > _b) ? (uint64_t) _a - (uint64_t) _b : (uint64_t) _b - (uint64_t) _a;
+}
@@ -0,0 +1,12 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h>
+
+double variance_gmp(double const* values, size_t size);
+
+double relative_error(double value, double reference);
+uint64_t ulp_distance(double a, double b);
+
+#endif /* REFERENCE_H */
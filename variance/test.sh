@@ -1,3 +1,3 @@
 #!/bin/bash
 
-gcc -O2 -msse4.1 -o test -lm -lgmp -lgsl -lgslcblas cle_math.c test.c
+gcc -O2 -msse4.1 -o test -lm -lgmp -lgsl -lgslcblas cle_math.c datagen.c reference.c test.c